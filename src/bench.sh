@@ -0,0 +1,2 @@
+g++ -O2 -pthread nfa_dfa_converter.cpp -o bench
+./bench --bench-suite=json > bench_$(git rev-parse --short HEAD).json
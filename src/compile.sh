@@ -1,2 +1,2 @@
-g++ nfa_dfa_converter.cpp
+g++ -O2 -pthread nfa_dfa_converter.cpp
 ./a.out ../examples/nfa_example.nfa
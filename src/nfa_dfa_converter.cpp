@@ -1,420 +1,5253 @@
-#include <iostream>
-#include <vector>
-#include <string>
-#include <fstream>
-#include <unordered_map>
-#include <unordered_set>
-
-using namespace std;
-
-//nfa class (5-tuple) ---------------------------------------
-class NFA {
-    public:
-        //member variables are representative of elements of 5-tuple
-        //5-tuple (nfa states, alphabet, start state, accept states, transitions)
-        vector<int> states;
-        vector<char> alphabet;
-        int start_state;
-        vector<int> accept_states; //these needs to separate based on commas
-        unordered_map<int, unordered_map<char, vector<int>>> transitions;
-
-        //create an NFA from a file
-        NFA(const string filename);
-        //print out NFA info (mainly for testing)
-        void print_out() const;
-
-    private:
-        //inline functions to process a file into a dfa
-        inline void parse_states(const string line);
-        inline void parse_alphabet(const string line);
-        inline void get_start_state(const string line);
-        inline void parse_valid_accept_states(const string line);
-        inline void parse_transition(const string line);
-};
-
-//given an nfa file, parse for nfa 5-tuple
-NFA::NFA(const string filename) {
-    ifstream parse{ filename };
-    string current; int line_number = 0;
-    while(getline(parse, current)) {
-        if(line_number < 4) {
-            if(line_number == 0) parse_states(current);
-            if(line_number == 1) parse_alphabet(current);
-            if(line_number == 2) get_start_state(current);
-            if(line_number == 3) parse_valid_accept_states(current);
-        } else {
-            parse_transition(current);
-        }
-        line_number++;
-    }
-}
-
-inline void NFA::parse_states(const string line) {
-    for(int i = 1; i < line.length(); i += 4) {
-        states.push_back(line[i] - '0');
-    }
-}
-
-inline void NFA::parse_alphabet(const string line) {
-    for(int i = 0; i < line.length(); i += 2) {
-        alphabet.push_back(line[i]);
-    }
-}
-
-inline void NFA::get_start_state(const string line) {
-    // cout << line << endl;
-    start_state = line[1] - '0';
-}
-
-inline void NFA::parse_valid_accept_states(const string line) {
-    for(int i = 1; i < line.length(); i += 4) {
-        accept_states.push_back(line[i] - '0');
-    }
-}
-
-//check for epsilons in the line
-inline void NFA::parse_transition(const string line) {
-    int init_state = line[1] - '0';
-    // cout << line << endl;
-
-    char symbol;
-    if (line[5] == 'E') {
-        if (line[6] == 'P' && line[7] == 'S') {
-            symbol = '-';
-        } 
-    } else {
-        symbol = line[5];
-    }
-
-    int end_state = line[line.length() - 2] - '0';
-
-    auto iter = transitions.find(init_state);
-    if (iter != end(transitions)) { //contains this state
-        auto iter2 = (iter->second).find(symbol);
-        if (iter2 != end(iter->second)) {
-            iter2->second.push_back(end_state);
-        } else {
-            vector<int> states; states.push_back(end_state);
-            iter->second.insert({symbol, states});
-        }
-    } else {
-        vector<int> states; states.push_back(end_state);
-        unordered_map<char, vector<int>> symbol_map;
-        symbol_map.insert({symbol, states});
-        transitions.insert({init_state, symbol_map});
-    }
-}
-
-//print out nfa for testing
-void NFA::print_out() const {
-    for(auto i : states) {
-        cout << i << " ";
-    } cout << endl;
-
-    for(auto i : alphabet) {
-        cout << i << " ";
-    } cout << endl;
-
-    cout << start_state << endl;
-
-    for(auto i : accept_states) {
-        cout << i << " ";
-    } cout << endl;
-
-    for(auto i : transitions) {
-        cout << i.first << ": " << endl;
-        for (auto j : i.second) {
-            cout << "symbol: " << j.first << ": ";
-            for (auto k : j.second) {
-                cout << k << " ";
-            } cout << endl;
-        }
-    }
-}
-
-//dfa class (5-tuple) ---------------------------------------
-class DFA {
-    //all dfa_states are essentially sets. this helps avoid duplicates, 
-    //and now we can find single states in constant time
-    //comparing sets can also be down using the == operator
-    typedef unordered_set<int> dfa_state;
-
-    private:
-        //the 5-tuple, including the nfa_start_state so we can call on it later
-        vector<dfa_state> states;
-        vector<char> alphabet;
-        int nfa_start_state;
-        dfa_state start_state;
-        vector<dfa_state> accept_states;
-        vector<pair<dfa_state, unordered_map<char, dfa_state>>> transitions;
-
-        //recursively epsilon a certain state
-        void epsilon_check(int state, dfa_state& states, 
-                           const NFA &nfa, int init);
-        //acquire dfa start state (epsilon check nfa start state)
-        void get_start_state(const NFA &nfa);
-        //starts recursive transition generator
-        void generate_transitions_dynamic(const NFA &nfa);
-        //recursive helper function
-        void generate_transitions (dfa_state process_state, 
-                                   vector<dfa_state>& explored_states,
-                                   const NFA &nfa);
-        
-        //functions returning strings for printing
-        string string_states() const;
-        inline string string_alphabet() const;
-        inline string string_start_states() const;
-        string string_accept_states() const;
-        vector<string> string_transitions_vec() const;
-
-    public:
-        DFA(const NFA &nfa);
-        void print_to_file(string file_name) const;
-};
-
-//create the dfa -- based around the 5-tuple. the states are created along
-//with transitions
-DFA::DFA(const NFA &nfa) {
-    get_start_state(nfa);
-    alphabet = nfa.alphabet; 
-    nfa_start_state = nfa.start_state;
-    generate_transitions_dynamic(nfa);
-}
-
-//the start the state is the nfa start state, with epsilon checking
-void DFA::get_start_state(const NFA &nfa) {
-    start_state.insert(nfa.start_state);
-    epsilon_check(nfa.start_state, start_state, nfa, 1);
-}
-
-//starter function for generating transitions recursively
-void DFA::generate_transitions_dynamic (const NFA &nfa) {
-    vector<dfa_state> explored_states;
-    generate_transitions(start_state, explored_states, nfa);
-}
-
-//generate transitions for a dfa state, and then process the created end states
-//(recursive)
-void DFA::generate_transitions (dfa_state process_state, vector<dfa_state>& explored_states, 
-                                const NFA &nfa) {
-    //base case. make sure we haven't already processed this state
-    for (auto state : explored_states) {
-        if (state == process_state) {
-            return;
-        } 
-    }
-
-    unordered_map<char, dfa_state> process_state_mappings;
-    unordered_set<int> states_checked; //technically the same data type as
-                                       //dfa state but not literally a dfa state 
-
-    //equip map with all possible mappings for each character
-    for (char alpha : alphabet) {
-        dfa_state state;
-        process_state_mappings.insert({alpha, state});
-    }
-
-    //move everything into a vector. this way we can operate on the vector
-    //while changing it. 
-    vector<int> dfa_state_vector(process_state.begin(), process_state.end());
-
-    //go through the character mappings for each state
-    //add all their corresponding states to map, espilon check them
-    for (int i = 0; i < dfa_state_vector.size(); i ++) {
-
-        if (states_checked.find(dfa_state_vector[i]) != end(states_checked)) continue;
-        auto nfa_iter = nfa.transitions.find(dfa_state_vector[i]);
-
-        for (char alpha : alphabet) {
-            auto char_iter = nfa_iter->second.find(alpha);
-            auto mapping_check = process_state_mappings.find(alpha);
-
-            if (char_iter != nfa_iter->second.end()) {
-                for(auto state : char_iter->second) { //for states associated with char
-                    mapping_check->second.insert(state); //push back states to their corresponding letter
-                    epsilon_check(state, mapping_check->second, nfa, 1);
-                }
-            }
-        }
-        //since we aren't using a set for dfa_states in this case, 
-        //we need to be careful of duplicates
-        states_checked.insert(dfa_state_vector[i]);
-    } 
-
-    //copy everything back into a set to get rid of duplicates
-    dfa_state set(dfa_state_vector.begin(), dfa_state_vector.end());
-
-    transitions.push_back({set, process_state_mappings}); //push our transition
-    explored_states.push_back(set); //push the states that we've checked
-    states.push_back(set); //push the states to the overall dfa state list
-
-    //this checks if the set contains the original start state
-    //meeting this condition would mean that the state is an accept state
-    if (set.find(nfa_start_state) != set.end()) accept_states.push_back(set);
-
-    //for each of the states at the end of our mappings, 
-    //generate transitions for them
-    for (auto mapping : process_state_mappings) {
-        generate_transitions(mapping.second, explored_states, nfa);
-    }
-}
-
-//recursively epsilon check a single state
-void DFA::epsilon_check(int state, dfa_state& states, const NFA &nfa, int init) {
-    //base case. if the state has already been processed/added to states
-    if (states.find(state) != states.end() && init == 0) return;
-
-    //find the state in the nfa, and locate epsilon transitions
-    auto transition_iter = nfa.transitions.find(state);
-    auto epsilon_associations = transition_iter->second.find('-');
-
-    //another base case. if this state doesn't have epislon transitions, return
-    if (epsilon_associations == end(transition_iter->second)) return;
-
-    //there are epsilon transitions to certain states. add them to the state list,
-    //and epsilon check them
-    for(auto i : epsilon_associations->second) {
-        states.insert(i);
-        epsilon_check(i, states, nfa, 0);
-    }
-}
-
-//a function for printing a dfa to a file
-void DFA::print_to_file(string file_name) const {
-    ofstream outfile;
-    outfile.open (file_name + ".dfa");
-
-    //list of states
-    outfile << string_states() << endl;
-    //list of symbols
-    outfile << string_alphabet() << endl;
-    //start states
-    outfile << string_start_states() << endl;
-    //valid accept states
-    outfile << string_accept_states() << endl;
-    //transition function
-    for (auto transition_str : string_transitions_vec()) {
-        outfile << transition_str << " " << endl;
-    }
-
-    outfile.close();
-}
-
-//helper function to stringify all states
-string DFA::string_states() const {
-    string state_list = "";
-    for (auto state : states) {
-        if (state.size() > 0) {
-            string power_rep = "{";
-            for (auto members : state) {
-                power_rep += '0' + members;
-                power_rep += ',';
-            }
-            power_rep[power_rep.size() - 1] = '}';
-            state_list += power_rep + " ";
-        } else {
-            state_list += "{EM} ";
-        }
-    }
-
-    return state_list;
-}
-
-//helper function to stringify alphabet
-inline string DFA::string_alphabet() const {
-    string alphabet_string = "";
-    for (auto symbol : alphabet) {
-        alphabet_string += symbol;
-        alphabet_string += '\t';
-    } 
-
-    return alphabet_string;
-}
-
-//helper function to stringify start states
-inline string DFA::string_start_states() const {
-    string start_state_string = "{";
-    for (auto states : start_state) {
-        start_state_string += '0' + states;
-        start_state_string += ',';
-    }
-
-    start_state_string[start_state_string.size() - 1] = '}';
-    return start_state_string;
-}
-
-//helper function to stringify accept states
-inline string DFA::string_accept_states() const {
-    string accept_state_list = "";
-    for (auto states : accept_states) {
-        if (states.size() > 0) {
-            string power_rep = "{";
-            for (int i : states) {
-                // cout << members << endl;
-                power_rep += '0' + i;
-                power_rep += ',';
-            }
-            power_rep[power_rep.size() - 1] = '}';
-            accept_state_list += power_rep + " ";
-        }
-    }
-
-    return accept_state_list;
-}
-
-//helper function to create a vector of strings representing transitions
-vector<string> DFA::string_transitions_vec() const {
-    vector<string> str_trans;
-    for (auto transition : transitions) {
-        string transition_rep = "{";
-        if (transition.first.size() > 0) {
-            for (auto states : transition.first) {
-                transition_rep += '0' + states;
-                transition_rep += ',';
-            }
-            transition_rep[transition_rep.size() - 1] = '}';
-        } else {
-            transition_rep += "EM";
-            transition_rep += '}';
-        }
-        transition_rep += ", ";
-        for (auto map : transition.second) {
-            string final_rep = transition_rep;
-            final_rep += map.first;
-
-            final_rep += " = {";
-            if (map.second.size() > 0) {
-                for (auto state : map.second) {
-                    final_rep += '0' + state;
-                    final_rep += ',';
-                }
-                final_rep[final_rep.size() - 1] = '}';
-            } else {
-                final_rep += "EM";
-                final_rep += '}';
-            }
-            str_trans.push_back(final_rep);
-        }
-    }
-
-    return str_trans;
-}
-
-//main ------------------------------------------------------
-int main (int argc, char** argv) {
-
-    //look for a file from which to create nfa
-    if (argc != 2) {
-        cerr << "requires file name!" << endl;
-        exit(EXIT_FAILURE);
-    }
-
-    NFA my_NFA = NFA(argv[1]); //create nfa from file
-    DFA my_DFA = DFA(my_NFA); //create dfa from nfa
-
-    //there wasn't a specification for naming the file the dfa prints to,
-    //so using the name converted dfa. 
-    my_DFA.print_to_file("converted_dfa"); //create a file
-
-    return 0;
-}
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <charconv>
+#include <memory>
+#include <random>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+//run statistics ---------------------------------------------
+//counters for --stats. each thread counts into its own thread_stats, and
+//worker threads fold theirs into merged_stats when they finish, so the hot
+//paths never share a cache line. build with -DNFA_DFA_STATS=0 and every
+//STAT_ macro compiles to nothing, arguments included.
+//heap allocations are only counted with -DNFA_DFA_COUNT_ALLOCS=1, which
+//replaces the global operator new. other builds keep the stock allocator
+#ifndef NFA_DFA_STATS
+#define NFA_DFA_STATS 1
+#endif
+#ifndef NFA_DFA_COUNT_ALLOCS
+#define NFA_DFA_COUNT_ALLOCS 0
+#endif
+
+struct stat_counters {
+    uint64_t intern_probes = 0;     //table slots looked at while interning
+    uint64_t intern_collisions = 0; //slots holding some other subset
+    uint64_t closure_lookups = 0;
+    uint64_t closure_hits = 0;      //lookups answered by a stored closure
+    uint64_t peak_subset = 0;       //most nfa states in one dfa state
+    uint64_t heap_allocations = 0;  //calls to operator new
+
+    void merge(const stat_counters &other) {
+        heap_allocations += other.heap_allocations;
+        intern_probes += other.intern_probes;
+        intern_collisions += other.intern_collisions;
+        closure_lookups += other.closure_lookups;
+        closure_hits += other.closure_hits;
+        peak_subset = max(peak_subset, other.peak_subset);
+    }
+};
+
+#if NFA_DFA_STATS
+thread_local stat_counters thread_stats;
+stat_counters merged_stats;
+mutex merged_stats_lock;
+
+//fold this thread's counters into merged_stats
+void merge_thread_stats() {
+    lock_guard<mutex> guard(merged_stats_lock);
+    merged_stats.merge(thread_stats);
+    thread_stats = stat_counters();
+}
+
+#define STAT_ADD(counter, n) (thread_stats.counter += (n))
+#define STAT_MAX(counter, n) (thread_stats.counter = max<uint64_t>(thread_stats.counter, (n)))
+#define STAT_MERGE() merge_thread_stats()
+#else
+#define STAT_ADD(counter, n) ((void) 0)
+#define STAT_MAX(counter, n) ((void) 0)
+#define STAT_MERGE() ((void) 0)
+#endif
+
+#if NFA_DFA_STATS && NFA_DFA_COUNT_ALLOCS
+//count every heap allocation. new[] and the nothrow forms go through this.
+//delete stays out of line, or gcc sees free() inlined against a new and
+//warns about a mismatch that isn't there
+void* operator new(size_t size) {
+    STAT_ADD(heap_allocations, 1);
+    void* memory = malloc(size ? size : 1);
+    if (memory == nullptr) throw bad_alloc();
+    return memory;
+}
+__attribute__((noinline)) void operator delete(void* memory) noexcept { free(memory); }
+__attribute__((noinline)) void operator delete(void* memory, size_t) noexcept { free(memory); }
+#endif
+
+//monotonic arena --------------------------------------------
+//bump allocation out of large chunks. nothing is freed on its own: every
+//chunk goes at once when the arena is destroyed, and reset() rewinds it so
+//the same chunks are handed out again. allocations are 8 byte aligned
+class Arena {
+    public:
+        Arena() : current(0), used(0) {}
+
+        //room for count uninitialized Ts
+        template<class T> T* allocate(size_t count) {
+            size_t bytes = (count * sizeof(T) + 7) & ~size_t(7);
+            if (chunks.empty() || bytes > chunks[current].size - used) next_chunk(bytes);
+            T* result = (T*) (chunks[current].memory.get() + used);
+            used += bytes;
+            return result;
+        }
+        void reset() { current = 0; used = 0; }
+        //take over the chunks other has handed out from, so what was 
+        //allocated there lives as long as this arena. other is left empty
+        void adopt(Arena &other);
+        //bytes of the chunks in use since the last reset
+        size_t bytes() const {
+            size_t total = 0;
+            for (size_t i = 0; i < chunks.size() && i <= current; i++) total += chunks[i].size;
+            return total;
+        }
+
+    private:
+        static constexpr size_t first_chunk = 1 << 16;
+        static constexpr size_t max_chunk = 1 << 24;
+        struct chunk {
+            unique_ptr<char[]> memory;
+            size_t size;
+        };
+        vector<chunk> chunks;
+        size_t current; //chunk being allocated from
+        size_t used;    //bytes of it handed out
+
+        void next_chunk(size_t bytes);
+};
+
+//move on to a chunk with room for bytes: one kept from before a reset, or
+//else a new one twice the size of the last
+void Arena::next_chunk(size_t bytes) {
+    while (!chunks.empty() && current + 1 < chunks.size()) {
+        current++;
+        used = 0;
+        if (chunks[current].size >= bytes) return;
+    }
+    size_t size = chunks.empty() ? first_chunk : min(chunks.back().size * 2, max_chunk);
+    size = max(size, bytes);
+    chunks.push_back({unique_ptr<char[]>(new char[size]), size});
+    current = chunks.size() - 1;
+    used = 0;
+}
+
+void Arena::adopt(Arena &other) {
+    if (other.chunks.empty()) return;
+    other.chunks.resize(other.current + 1); //the rest hold nothing
+    if (chunks.empty()) {
+        chunks = move(other.chunks);
+        current = other.current;
+        used = other.used;
+    } else {
+        //in front of the chunk being allocated from, so they count as in use
+        size_t taken = other.chunks.size();
+        chunks.insert(chunks.begin(), make_move_iterator(other.chunks.begin()), 
+                      make_move_iterator(other.chunks.end()));
+        current += taken;
+    }
+    other.chunks.clear();
+    other.current = other.used = 0;
+}
+
+//state set (bitset) ----------------------------------------
+//a subset of nfa states stored as a dense bitset, one bit per nfa state.
+//small nfas keep their words inline, larger ones spill into a vector, so
+//union/compare are a handful of word operations instead of hash walks.
+//StateSetRef is a read only view of the same words stored somewhere else,
+//as they are in a SubsetTable; every read only operation works on views
+class StateSetRef {
+    public:
+        StateSetRef(const uint64_t* words, int num_words) : bits(words), num_words(num_words) {}
+
+        bool empty() const;
+        int size() const;
+        bool intersects(StateSetRef other) const;
+        bool operator==(StateSetRef other) const;
+        uint64_t hash() const;
+
+        //call f(state) for each member, in ascending order
+        template<class F> void for_each(F f) const;
+
+        int word_count() const { return num_words; }
+        const uint64_t* words() const { return bits; }
+
+    private:
+        const uint64_t* bits;
+        int num_words;
+};
+
+bool StateSetRef::empty() const {
+    for (int i = 0; i < num_words; i++) {
+        if (bits[i]) return false;
+    }
+    return true;
+}
+
+int StateSetRef::size() const {
+    int count = 0;
+    for (int i = 0; i < num_words; i++) count += __builtin_popcountll(bits[i]);
+    return count;
+}
+
+bool StateSetRef::intersects(StateSetRef other) const {
+    for (int i = 0; i < num_words; i++) {
+        if (bits[i] & other.bits[i]) return true;
+    }
+    return false;
+}
+
+bool StateSetRef::operator==(StateSetRef other) const {
+    if (num_words != other.num_words) return false;
+    for (int i = 0; i < num_words; i++) {
+        if (bits[i] != other.bits[i]) return false;
+    }
+    return true;
+}
+
+//word-wise multiply/rotate hash. equal sets always hash equally since they
+//have the same number of words
+uint64_t StateSetRef::hash() const {
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < num_words; i++) {
+        h ^= bits[i] + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        h *= 0xff51afd7ed558ccdull;
+    }
+    return h ^ (h >> 33);
+}
+
+template<class F> void StateSetRef::for_each(F f) const {
+    for (int i = 0; i < num_words; i++) {
+        uint64_t bits_left = bits[i];
+        while (bits_left) {
+            f(i * 64 + __builtin_ctzll(bits_left));
+            bits_left &= bits_left - 1;
+        }
+    }
+}
+
+class StateSet {
+    public:
+        static const int inline_words = 4; //up to 256 nfa states inline
+
+        StateSet(int universe = 0);
+        //an owning copy of a view
+        explicit StateSet(StateSetRef other);
+        operator StateSetRef() const { return StateSetRef(words(), num_words); }
+
+        void insert(int state);
+        bool contains(int state) const;
+        void clear();
+        bool empty() const { return StateSetRef(*this).empty(); }
+        int size() const { return StateSetRef(*this).size(); }
+        bool intersects(StateSetRef other) const { return StateSetRef(*this).intersects(other); }
+
+        StateSet& operator|=(const StateSet &other);
+        bool operator==(const StateSet &other) const { return StateSetRef(*this) == other; }
+        bool operator!=(const StateSet &other) const { return !(*this == other); }
+        uint64_t hash() const { return StateSetRef(*this).hash(); }
+
+        //call f(state) for each member, in ascending order
+        template<class F> void for_each(F f) const { StateSetRef(*this).for_each(f); }
+
+        int word_count() const { return num_words; }
+        uint64_t* words() { return num_words <= inline_words ? small : large.data(); }
+        const uint64_t* words() const { 
+            return num_words <= inline_words ? small : large.data(); 
+        }
+
+    private:
+        int num_words;
+        uint64_t small[inline_words];
+        vector<uint64_t> large;
+};
+
+StateSet::StateSet(int universe) {
+    num_words = (universe + 63) / 64;
+    for (int i = 0; i < inline_words; i++) small[i] = 0;
+    if (num_words > inline_words) large.assign(num_words, 0);
+}
+
+StateSet::StateSet(StateSetRef other) : StateSet(other.word_count() * 64) {
+    copy(other.words(), other.words() + num_words, words());
+}
+
+void StateSet::insert(int state) {
+    words()[state >> 6] |= uint64_t(1) << (state & 63);
+}
+
+bool StateSet::contains(int state) const {
+    if (state < 0 || (state >> 6) >= num_words) return false;
+    return (words()[state >> 6] >> (state & 63)) & 1;
+}
+
+void StateSet::clear() {
+    uint64_t* w = words();
+    for (int i = 0; i < num_words; i++) w[i] = 0;
+}
+
+StateSet& StateSet::operator|=(const StateSet &other) {
+    uint64_t* a = words(); const uint64_t* b = other.words();
+    for (int i = 0; i < num_words; i++) a[i] |= b[i];
+    return *this;
+}
+
+//subset interning table ------------------------------------
+//maps each discovered subset to a dense dfa state id. open addressing over
+//a power of two slot array; each subset is hashed once, and the cached hash
+//is compared before any words are, so duplicate checks are O(1) expected.
+//the words of every subset are copied once into an arena and never move,
+//so a view from subset(id) stays valid as the table grows
+class SubsetTable {
+    public:
+        SubsetTable();
+
+        //id of subset, adding it if it is new. inserted reports which happened
+        int intern(StateSetRef subset, bool &inserted) {
+            return intern(subset, subset.hash(), inserted);
+        }
+        int intern(StateSetRef subset, uint64_t hash, bool &inserted);
+        //id of subset, or -1 if it hasn't been seen
+        int find(StateSetRef subset) const;
+        //give the next id to a subset known not to be in the table, without
+        //copying its words. they must outlive the table, as they do in the
+        //arena of a table passed to adopt_storage
+        int append(StateSetRef stored, uint64_t hash);
+        //take over the arena other's subsets are stored in
+        void adopt_storage(SubsetTable &other) { arena.adopt(other.arena); }
+
+        StateSetRef subset(int id) const { return StateSetRef(words_of[id], num_words); }
+        uint64_t hash(int id) const { return hashes[id]; }
+        int size() const { return words_of.size(); }
+        //forget every subset. ids start over from 0, reusing the arena but
+        //giving back the index arrays
+        void clear();
+        //heap bytes the table holds: arena chunks in use and index arrays
+        size_t bytes() const {
+            return arena.bytes() + words_of.capacity() * sizeof(const uint64_t*) 
+                 + hashes.capacity() * sizeof(uint64_t) + slots.capacity() * sizeof(int);
+        }
+
+    private:
+        Arena arena;                      //every subset's words
+        vector<const uint64_t*> words_of; //indexed by id
+        vector<uint64_t> hashes;          //indexed by id
+        vector<int> slots;                //-1 when empty, otherwise an id
+        int num_words;                    //of every subset in the table
+
+        int probe(StateSetRef subset, uint64_t hash) const;
+        void grow();
+};
+
+SubsetTable::SubsetTable() : slots(64, -1), num_words(0) {}
+
+//slot holding subset, or the empty slot where it belongs
+int SubsetTable::probe(StateSetRef subset, uint64_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    STAT_ADD(intern_probes, 1);
+    while (slots[slot] != -1) {
+        int id = slots[slot];
+        if (hashes[id] == hash && this->subset(id) == subset) break;
+        STAT_ADD(intern_collisions, 1);
+        STAT_ADD(intern_probes, 1);
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+int SubsetTable::find(StateSetRef subset) const {
+    if (words_of.empty()) return -1;
+    return slots[probe(subset, subset.hash())];
+}
+
+int SubsetTable::intern(StateSetRef subset, uint64_t hash, bool &inserted) {
+    if (words_of.empty()) num_words = subset.word_count();
+    int slot = probe(subset, hash);
+    if (slots[slot] != -1) {
+        inserted = false;
+        return slots[slot];
+    }
+
+    inserted = true;
+    int id = words_of.size();
+    uint64_t* words = arena.allocate<uint64_t>(num_words);
+    copy(subset.words(), subset.words() + num_words, words);
+    words_of.push_back(words);
+    hashes.push_back(hash);
+    slots[slot] = id;
+
+    //keep the load factor under one half
+    if (words_of.size() * 2 > slots.size()) grow();
+    return id;
+}
+
+int SubsetTable::append(StateSetRef stored, uint64_t hash) {
+    if (words_of.empty()) num_words = stored.word_count();
+    int id = words_of.size();
+    words_of.push_back(stored.words());
+    hashes.push_back(hash);
+
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while (slots[slot] != -1) slot = (slot + 1) & mask;
+    slots[slot] = id;
+
+    if (words_of.size() * 2 > slots.size()) grow();
+    return id;
+}
+
+void SubsetTable::clear() {
+    arena.reset();
+    vector<const uint64_t*>().swap(words_of);
+    vector<uint64_t>().swap(hashes);
+    vector<int>(64, -1).swap(slots);
+}
+
+void SubsetTable::grow() {
+    slots.assign(slots.size() * 2, -1);
+    size_t mask = slots.size() - 1;
+    for (int id = 0; id < (int) words_of.size(); id++) {
+        size_t slot = hashes[id] & mask;
+        while (slots[slot] != -1) slot = (slot + 1) & mask;
+        slots[slot] = id;
+    }
+}
+
+//concurrent subset table ----------------------------------
+//subsets spread over independently locked SubsetTable shards by hash, so 
+//threads interning different subsets rarely wait on each other. ids are 
+//global and dense, handed out by an atomic counter as subsets are added.
+//once interning is over, index_ids() finds every subset by its global id,
+//and move_storage_into hands the shards' words over to a plain SubsetTable
+class ConcurrentSubsetTable {
+    public:
+        ConcurrentSubsetTable(int shard_count = 64) : shards(shard_count), next_id(0) {}
+
+        //id of subset, adding it if it is new. stored is set to the table's
+        //own copy, which stays put as the table grows
+        int intern(StateSetRef subset, bool &inserted, StateSetRef &stored);
+        int size() const { return next_id.load(); }
+
+        void index_ids();
+        StateSetRef subset(int id) const { return shards[location[id].first].table.subset(location[id].second); }
+        uint64_t hash(int id) const { return shards[location[id].first].table.hash(location[id].second); }
+        //let table own the words of every subset, so views of them stay
+        //valid after this table is gone
+        void move_storage_into(SubsetTable &table);
+
+    private:
+        struct shard {
+            mutex lock;
+            SubsetTable table;
+            vector<int> global_ids; //indexed by the shard's own ids
+        };
+        vector<shard> shards;
+        atomic<int> next_id;
+        vector<pair<int, int>> location; //global id -> (shard, shard's id)
+};
+
+int ConcurrentSubsetTable::intern(StateSetRef subset, bool &inserted, StateSetRef &stored) {
+    uint64_t hash = subset.hash();
+    shard &owner = shards[(hash >> 40) % shards.size()];
+
+    lock_guard<mutex> guard(owner.lock);
+    int local = owner.table.intern(subset, hash, inserted);
+    if (inserted) owner.global_ids.push_back(next_id.fetch_add(1));
+    stored = owner.table.subset(local);
+    return owner.global_ids[local];
+}
+
+void ConcurrentSubsetTable::index_ids() {
+    location.resize(size());
+    for (int s = 0; s < (int) shards.size(); s++) {
+        vector<int> &global_ids = shards[s].global_ids;
+        for (int local = 0; local < (int) global_ids.size(); local++) location[global_ids[local]] = {s, local};
+    }
+}
+
+void ConcurrentSubsetTable::move_storage_into(SubsetTable &table) {
+    for (auto &owner : shards) table.adopt_storage(owner.table);
+}
+
+//memory mapped file ---------------------------------------
+//a whole file mapped read only. data() is null for an empty file. advice
+//is passed to madvise: sequential for files read front to back, random for
+//tables that are looked up
+class MappedFile {
+    public:
+        MappedFile(const string &filename, int advice = MADV_SEQUENTIAL);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const char* bytes;
+        size_t length;
+};
+
+MappedFile::MappedFile(const string &filename, int advice) : bytes(nullptr), length(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        cerr << "can't open " << filename << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    length = info.st_size;
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            cerr << "can't map " << filename << endl;
+            exit(EXIT_FAILURE);
+        }
+        madvise(mapped, length, advice);
+        bytes = (const char*) mapped;
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (bytes != nullptr) munmap((void*) bytes, length);
+}
+
+//buffered writer -------------------------------------------
+//an output file written through one large reusable buffer, which goes to
+//the file only when full and when the writer is destroyed
+class BufferedWriter {
+    public:
+        BufferedWriter(const string &filename, size_t capacity = 1 << 20);
+        ~BufferedWriter();
+        BufferedWriter(const BufferedWriter&) = delete;
+        BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+        void write(string_view text) {
+            if (text.size() > buffer.size() - used) {
+                flush();
+                if (text.size() > buffer.size()) return write_through(text);
+            }
+            memcpy(&buffer[used], text.data(), text.size());
+            used += text.size();
+        }
+        void put(char c) {
+            if (used == buffer.size()) flush();
+            buffer[used++] = c;
+        }
+        //bytes handed to the writer so far
+        size_t bytes_written() const { return total + used; }
+
+    private:
+        void flush();
+        void write_through(string_view text);
+
+        string filename;
+        int fd;
+        vector<char> buffer;
+        size_t used;
+        size_t total; //bytes already written to the file
+};
+
+BufferedWriter::BufferedWriter(const string &filename, size_t capacity) 
+    : filename(filename), buffer(capacity), used(0), total(0) {
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "can't create " << filename << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+BufferedWriter::~BufferedWriter() {
+    flush();
+    close(fd);
+}
+
+void BufferedWriter::flush() {
+    write_through(string_view(buffer.data(), used));
+    used = 0;
+}
+
+void BufferedWriter::write_through(string_view text) {
+    const char* next = text.data();
+    size_t left = text.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, next, left);
+        if (written < 0) {
+            cerr << "can't write " << filename << endl;
+            exit(EXIT_FAILURE);
+        }
+        next += written;
+        left -= written;
+    }
+    total += text.size();
+}
+
+//a contiguous run of nfa states, as handed out by the csr transition arrays
+struct StateRange {
+    const int* first;
+    const int* last;
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    int size() const { return last - first; }
+};
+
+//nfa class (5-tuple) ---------------------------------------
+//a malformed nfa file, thrown in place of exiting by an NFA built with
+//exit_on_error false. message is what would have been printed
+struct NFAError {
+    string message;
+};
+
+class NFA {
+    public:
+        //member variables are representative of elements of 5-tuple
+        //5-tuple (nfa states, alphabet, start state, accept states, transitions).
+        //states are interned to dense ids in order of first appearance, and
+        //state_names[id] is the label the file gave it
+        vector<int> states;
+        vector<string> alphabet;
+        int start_state;
+        vector<int> accept_states;
+        vector<string> state_names;
+        int universe; //number of state ids
+
+        //transitions as parsed, in file order. symbol is an alphabet index
+        static constexpr int epsilon = -1;
+        static constexpr int unknown_symbol = -2;
+        struct edge { int from; int symbol; int to; };
+        vector<edge> edges;
+
+        //symbols that no transition can tell apart share an equivalence class.
+        //symbol_class[a] is the class of alphabet[a], class_symbol[c] is one
+        //symbol in class c, and byte_class maps an input byte to its class,
+        //or -1 for bytes outside the alphabet
+        vector<int> symbol_class;
+        vector<int> class_symbol;
+        int byte_class[256];
+        int class_count() const { return class_symbol.size(); }
+
+        //seconds spent mapping and parsing the file, and building the
+        //transition index and epsilon closures
+        double parse_seconds;
+        double closure_seconds;
+
+        //create an NFA from a file. a malformed file prints an error and 
+        //exits, or with exit_on_error false throws NFAError instead
+        NFA(const string filename, bool exit_on_error = true);
+        //the position (glushkov) automaton of a regular expression: a start
+        //state plus one state per symbol occurrence, with no epsilon edges.
+        //with thompson set, the classic epsilon nfa instead
+        static NFA from_regex(const string &pattern, bool thompson = false);
+        //edit the nfa in place with a delta file (see apply) and rebuild its
+        //indexes. returns the states whose successors on some symbol, with 
+        //epsilon closures, may have changed, for DFA::update
+        StateSet apply(const string &delta_file);
+        //print out NFA info (mainly for testing)
+        void print_out() const;
+
+        //add the state plus everything reachable from it by epsilon 
+        //transitions to set
+        void add_epsilon_closure(int state, StateSet &set) const {
+            int closure = closure_of[state];
+            STAT_ADD(closure_lookups, 1);
+            STAT_ADD(closure_hits, closure != -1);
+            if (closure == -1) set.insert(state);
+            else if (dense_closures) set |= scc_closures[closure];
+            else {
+                for (int i = closure_offsets[closure]; i < closure_offsets[closure + 1]; i++) {
+                    set.insert(closure_members[i]);
+                }
+            }
+        }
+        //targets of state on the symbol at alphabet[symbol]
+        StateRange targets(int state, int symbol) const {
+            int row = state * alphabet.size() + symbol;
+            return { &csr_targets[0] + csr_offsets[row], 
+                     &csr_targets[0] + csr_offsets[row + 1] };
+        }
+        //targets of state's epsilon transitions
+        StateRange epsilon_targets(int state) const {
+            return { &eps_targets[0] + eps_offsets[state], 
+                     &eps_targets[0] + eps_offsets[state + 1] };
+        }
+
+    private:
+        //after parsing, edges are laid out compressed sparse row. the targets
+        //for (state, symbol) are one contiguous run of csr_targets, starting
+        //at csr_offsets[state * alphabet.size() + symbol]. epsilon edges get
+        //their own arrays, indexed by state alone
+        vector<int> csr_offsets;
+        vector<int> csr_targets;
+        vector<int> eps_offsets;
+        vector<int> eps_targets;
+
+        //epsilon closures are computed once, per strongly connected component
+        //of the epsilon graph. every state in a cycle shares one closure.
+        //states with no epsilon transitions are their own closure and store
+        //nothing (closure_of is -1). closures are bitsets while the nfa is 
+        //small enough that a bitset per component is cheap; past 
+        //dense_closure_limit states they are sorted member lists instead
+        static const int dense_closure_limit = 1 << 14;
+        bool dense_closures;
+        vector<int> closure_of;
+        vector<StateSet> scc_closures;
+        vector<int> closure_offsets;
+        vector<int> closure_members;
+
+        //parsing state. plain numeric labels are looked up by value, 
+        //anything else by name
+        string source; //file name, for errors
+        bool exit_on_error = true;
+        vector<int> numeric_ids;
+        uint32_t identity_ids = 0; //labels below this have their value as id
+        unordered_map<string, int> named_ids;
+        int single_byte_symbol[256];
+        unordered_map<string, int> symbol_ids;
+
+        NFA() {}
+        //build everything derived from the 5-tuple once it is filled in
+        void build_indexes();
+        void build_csr();
+        void build_symbol_classes();
+        void build_epsilon_closures();
+
+        //functions to process the mapped file a line at a time. each works 
+        //on [begin, end) of the file in place
+        void parse(const char* begin, const char* end);
+        void parse_state_list(const char* begin, const char* end, 
+                              vector<int> &list, int line_number);
+        void parse_alphabet(const char* begin, const char* end);
+        void parse_transition(const char* begin, const char* end, int line_number);
+        bool parse_edge(const char* begin, const char* end, int line_number, edge &e,
+                        bool create = true);
+        const char* parse_state(const char* pos, const char* end, 
+                                int &state, int line_number, bool create = true);
+        int intern_state(string_view label);
+        int find_state(string_view label) const;
+        int find_symbol(string_view symbol) const;
+        [[noreturn]] void parse_error(int line_number, const string &what) const;
+};
+
+//report a malformed nfa file and stop, or hand it back to the caller
+void NFA::parse_error(int line_number, const string &what) const {
+    string message = source + " line " + to_string(line_number + 1) + ": " + what;
+    if (!exit_on_error) throw NFAError{message};
+    cerr << message << endl;
+    exit(EXIT_FAILURE);
+}
+
+static inline bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+//given an nfa file, parse for nfa 5-tuple
+NFA::NFA(const string filename, bool exit_on_error) : exit_on_error(exit_on_error) {
+    auto begin = chrono::steady_clock::now();
+    source = filename;
+    if (!exit_on_error && access(filename.c_str(), R_OK) != 0) throw NFAError{"can't open " + filename};
+    {
+        MappedFile file(filename);
+        parse(file.data(), file.data() + file.size());
+    }
+    auto parsed = chrono::steady_clock::now();
+
+    build_indexes();
+
+    parse_seconds = chrono::duration<double>(parsed - begin).count();
+    closure_seconds = chrono::duration<double>(chrono::steady_clock::now() - parsed).count();
+}
+
+void NFA::build_indexes() {
+    universe = max<int>(1, state_names.size());
+    build_csr();
+    build_symbol_classes();
+    build_epsilon_closures();
+}
+
+//single pass over the file, a line at a time. the first four lines are the
+//states, alphabet, start state and accept states; every line after that is
+//a transition. blank transition lines are skipped
+void NFA::parse(const char* begin, const char* end) {
+    for (int i = 0; i < 256; i++) single_byte_symbol[i] = unknown_symbol;
+    start_state = -1;
+
+    //nearly every line is a transition, so counting lines sizes edges once
+    size_t lines = 0;
+    for (const char* pos = begin; (pos = (const char*) memchr(pos, '\n', end - pos)) != nullptr; pos++) lines++;
+    edges.reserve(lines);
+
+    const char* line = begin;
+    int line_number = 0;
+    while (line < end) {
+        const char* line_end = (const char*) memchr(line, '\n', end - line);
+        if (line_end == nullptr) line_end = end;
+
+        if (line_number == 0) parse_state_list(line, line_end, states, line_number);
+        else if (line_number == 1) parse_alphabet(line, line_end);
+        else if (line_number == 2) {
+            vector<int> start;
+            parse_state_list(line, line_end, start, line_number);
+            if (start.size() != 1) parse_error(line_number, "expected one start state");
+            start_state = start[0];
+        }
+        else if (line_number == 3) parse_state_list(line, line_end, accept_states, line_number);
+        else parse_transition(line, line_end, line_number);
+
+        line = line_end + 1;
+        line_number++;
+    }
+
+    if (start_state == -1) parse_error(line_number, "missing start state");
+}
+
+//id of a state label, giving it the next id if it is new. labels that are 
+//plain numbers (no leading zeros) skip hashing and index a vector directly.
+//files usually list states 0, 1, 2... first, so each gets its own value as
+//id, and transitions between them are answered without touching the vector,
+//whose lookups are cache misses in random order on a large nfa
+int NFA::intern_state(string_view label) {
+    if (!label.empty() && (label[0] != '0' || label.size() == 1)) {
+        uint32_t value;
+        auto result = from_chars(label.data(), label.data() + label.size(), value);
+        if (result.ec == errc() && result.ptr == label.data() + label.size() 
+            && value < (1u << 24)) {
+            if (value < identity_ids) return value;
+            if (value >= numeric_ids.size()) {
+                numeric_ids.resize(max<size_t>(value + 1, numeric_ids.size() * 2), -1);
+            }
+            int &id = numeric_ids[value];
+            if (id == -1) {
+                id = state_names.size();
+                state_names.emplace_back(label);
+                while (identity_ids < numeric_ids.size() && numeric_ids[identity_ids] == (int) identity_ids) {
+                    identity_ids++;
+                }
+            }
+            return id;
+        }
+    }
+
+    auto inserted = named_ids.insert({string(label), (int) state_names.size()});
+    if (inserted.second) state_names.emplace_back(label);
+    return inserted.first->second;
+}
+
+//id of a state label, or -1 if it hasn't been seen
+int NFA::find_state(string_view label) const {
+    if (!label.empty() && (label[0] != '0' || label.size() == 1)) {
+        uint32_t value;
+        auto result = from_chars(label.data(), label.data() + label.size(), value);
+        if (result.ec == errc() && result.ptr == label.data() + label.size() 
+            && value < (1u << 24)) {
+            if (value < identity_ids) return value;
+            return value < numeric_ids.size() ? numeric_ids[value] : -1;
+        }
+    }
+    auto found = named_ids.find(string(label));
+    return found == named_ids.end() ? -1 : found->second;
+}
+
+//alphabet index of a symbol, or unknown_symbol if it isn't in the alphabet
+int NFA::find_symbol(string_view symbol) const {
+    if (symbol.size() == 1) return single_byte_symbol[(unsigned char) symbol[0]];
+    auto found = symbol_ids.find(string(symbol));
+    return found == symbol_ids.end() ? unknown_symbol : found->second;
+}
+
+//parse one {label} starting at pos (separators before it are skipped).
+//returns the position just past the closing brace
+const char* NFA::parse_state(const char* pos, const char* end, 
+                             int &state, int line_number, bool create) {
+    while (pos < end && is_separator(*pos)) pos++;
+    if (pos == end || *pos != '{') parse_error(line_number, "expected {state}");
+
+    const char* close = (const char*) memchr(pos, '}', end - pos);
+    if (close == nullptr) parse_error(line_number, "unterminated state");
+    string_view label(pos + 1, close - pos - 1);
+    state = create ? intern_state(label) : find_state(label);
+    if (state == -1) parse_error(line_number, "unknown state {" + string(label) + "}");
+    return close + 1;
+}
+
+void NFA::parse_state_list(const char* begin, const char* end, 
+                           vector<int> &list, int line_number) {
+    while (true) {
+        while (begin < end && is_separator(*begin)) begin++;
+        if (begin == end) return;
+        int state;
+        begin = parse_state(begin, end, state, line_number);
+        list.push_back(state);
+    }
+}
+
+//symbols are separated by whitespace and may be more than one character
+void NFA::parse_alphabet(const char* begin, const char* end) {
+    while (begin < end) {
+        while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r')) begin++;
+        const char* token = begin;
+        while (begin < end && *begin != ' ' && *begin != '\t' && *begin != '\r') begin++;
+        if (begin == token) continue;
+
+        string symbol(token, begin);
+        if (find_symbol(symbol) != unknown_symbol) continue; //listed twice
+        if (symbol.size() == 1) single_byte_symbol[(unsigned char) symbol[0]] = alphabet.size();
+        else symbol_ids[symbol] = alphabet.size();
+        alphabet.push_back(symbol);
+    }
+}
+
+//{from}, symbol = {to}. the symbol EPS is an epsilon transition, and
+//transitions on symbols outside the alphabet are dropped
+void NFA::parse_transition(const char* begin, const char* end, int line_number) {
+    edge e;
+    if (parse_edge(begin, end, line_number, e) && e.symbol != unknown_symbol) edges.push_back(e);
+}
+
+//the edge on [begin, end), false for a blank line. a symbol outside the
+//alphabet comes back as unknown_symbol. create as for parse_state
+bool NFA::parse_edge(const char* begin, const char* end, int line_number, edge &e, bool create) {
+    const char* pos = begin;
+    while (pos < end && (is_separator(*pos))) pos++;
+    if (pos == end) return false; //blank line
+
+    int from, to;
+    pos = parse_state(pos, end, from, line_number, create);
+
+    while (pos < end && is_separator(*pos)) pos++;
+    const char* token = pos;
+    while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '=') pos++;
+    string_view symbol(token, pos - token);
+    if (symbol.empty()) parse_error(line_number, "expected a symbol");
+
+    while (pos < end && (*pos == ' ' || *pos == '\t')) pos++;
+    if (pos == end || *pos != '=') parse_error(line_number, "expected =");
+    pos = parse_state(pos + 1, end, to, line_number, create);
+    while (pos < end && is_separator(*pos)) pos++;
+    if (pos != end) parse_error(line_number, "unexpected text after the transition");
+
+    e = {from, symbol == "EPS" ? epsilon : find_symbol(symbol), to};
+    return true;
+}
+
+//a delta file has one edit per line:
+//
+//  + {from}, symbol = {to}     add a transition (EPS for epsilon)
+//  - {from}, symbol = {to}     remove one
+//  +accept {state}             make a state accepting
+//  -accept {state}             or not
+//  +state {state}              add a state with no transitions
+//  -state {state}              remove every transition into and out of a 
+//                              state, and stop it accepting
+//
+//new states must be added with +state, and any other edit naming a state
+//the nfa doesn't have is an error, as is a symbol outside the alphabet.
+//removals apply to the nfa as it was, before any additions. a removed state keeps its id, but
+//nothing reaches it any more.
+//
+//a subset's successors can only change if a member has a transition 
+//added or removed, or a transition into a state whose epsilon closure 
+//changed. closures change for the states with an epsilon path, old or
+//new, to the source of an epsilon transition that was added or removed
+StateSet NFA::apply(const string &delta_file) {
+    auto begin = chrono::steady_clock::now();
+    source = delta_file;
+
+    vector<edge> added, removed;
+    vector<int> removed_states;
+    vector<pair<int, bool>> accept_edits;
+    {
+        //+state lines first, so every other edit sees the same states 
+        //wherever in the file they were added
+        MappedFile file(delta_file);
+        for (int pass = 0; pass < 2; pass++) {
+            const char* line = file.data();
+            const char* end = file.data() + file.size();
+            for (int line_number = 0; line < end; line_number++) {
+                const char* line_end = (const char*) memchr(line, '\n', end - line);
+                if (line_end == nullptr) line_end = end;
+                string_view text(line, line_end - line);
+                auto keyword = [&](const char* word) { return text.rfind(word, 0) == 0; };
+                line = line_end + 1;
+
+                int state;
+                edge e;
+                if (keyword("+state")) {
+                    if (pass == 1) continue;
+                    size_t known = state_names.size();
+                    parse_state(text.data() + 6, line_end, state, line_number);
+                    if (state_names.size() > known) states.push_back(state);
+                } else if (pass == 0) {
+                    continue;
+                } else if (keyword("+accept") || keyword("-accept")) {
+                    parse_state(text.data() + 7, line_end, state, line_number, false);
+                    accept_edits.push_back({state, text[0] == '+'});
+                } else if (keyword("-state")) {
+                    parse_state(text.data() + 6, line_end, state, line_number, false);
+                    if (state == start_state) parse_error(line_number, "can't remove the start state");
+                    removed_states.push_back(state);
+                } else if (keyword("+") || keyword("-")) {
+                    if (!parse_edge(text.data() + 1, line_end, line_number, e, false)) {
+                        parse_error(line_number, "expected a transition");
+                    }
+                    if (e.symbol == unknown_symbol) parse_error(line_number, "symbol is not in the alphabet");
+                    (text[0] == '+' ? added : removed).push_back(e);
+                } else if (text.find_first_not_of(" \t\r") != string_view::npos) {
+                    parse_error(line_number, "expected an edit");
+                }
+            }
+        }
+    }
+    int n = state_names.size();
+
+    //removals first, then additions
+    vector<bool> isolated(n, false);
+    for (int state : removed_states) isolated[state] = true;
+    auto key = [](const edge &e) { return to_string(e.from) + " " + to_string(e.symbol) + " " + to_string(e.to); };
+    unordered_set<string> removing;
+    for (const edge &e : removed) removing.insert(key(e));
+    vector<edge> kept, dropped;
+    for (const edge &e : edges) {
+        if (isolated[e.from] || isolated[e.to] || removing.count(key(e))) dropped.push_back(e);
+        else kept.push_back(e);
+    }
+    edges = move(kept);
+    edges.insert(edges.end(), added.begin(), added.end());
+
+    vector<bool> accepting(n, false);
+    for (int state : accept_states) accepting[state] = true;
+    for (auto &edit : accept_edits) accepting[edit.first] = edit.second;
+    for (int state : removed_states) accepting[state] = false;
+    accept_states.clear();
+    for (int state = 0; state < n; state++) {
+        if (accepting[state]) accept_states.push_back(state);
+    }
+
+    auto parsed = chrono::steady_clock::now();
+    build_indexes();
+
+    //closures changed for everything with an epsilon path to an edited
+    //epsilon source, over the union of the old and new epsilon edges
+    vector<vector<int>> epsilon_sources(universe);
+    vector<int> closure_changed;
+    vector<bool> seen(universe, false);
+    for (const vector<edge> *list : {&edges, &dropped}) {
+        for (const edge &e : *list) {
+            if (e.symbol == epsilon) epsilon_sources[e.to].push_back(e.from);
+        }
+    }
+    for (const vector<edge> *list : {&added, &dropped}) {
+        for (const edge &e : *list) {
+            if (e.symbol == epsilon && !seen[e.from]) {
+                seen[e.from] = true;
+                closure_changed.push_back(e.from);
+            }
+        }
+    }
+    for (size_t i = 0; i < closure_changed.size(); i++) {
+        for (int source : epsilon_sources[closure_changed[i]]) {
+            if (!seen[source]) {
+                seen[source] = true;
+                closure_changed.push_back(source);
+            }
+        }
+    }
+
+    StateSet touched(universe);
+    for (const vector<edge> *list : {&added, &dropped}) {
+        for (const edge &e : *list) {
+            if (e.symbol != epsilon) touched.insert(e.from);
+        }
+    }
+    for (const edge &e : edges) {
+        if (e.symbol != epsilon && seen[e.to]) touched.insert(e.from);
+    }
+
+    parse_seconds = chrono::duration<double>(parsed - begin).count();
+    closure_seconds = chrono::duration<double>(chrono::steady_clock::now() - parsed).count();
+    return touched;
+}
+
+//counting sort of edges into the csr arrays
+void NFA::build_csr() {
+    int rows = universe * alphabet.size();
+    csr_offsets.assign(rows + 1, 0);
+    eps_offsets.assign(universe + 1, 0);
+    for (auto &e : edges) {
+        if (e.symbol == epsilon) eps_offsets[e.from + 1]++;
+        else csr_offsets[e.from * alphabet.size() + e.symbol + 1]++;
+    }
+    for (int i = 0; i < rows; i++) csr_offsets[i + 1] += csr_offsets[i];
+    for (int i = 0; i < universe; i++) eps_offsets[i + 1] += eps_offsets[i];
+
+    csr_targets.resize(csr_offsets[rows] + 1); //never empty, so &csr_targets[0] is valid
+    eps_targets.resize(eps_offsets[universe] + 1);
+    vector<int> csr_fill(csr_offsets.begin(), csr_offsets.end() - 1);
+    vector<int> eps_fill(eps_offsets.begin(), eps_offsets.end() - 1);
+    for (auto &e : edges) {
+        if (e.symbol == epsilon) eps_targets[eps_fill[e.from]++] = e.to;
+        else csr_targets[csr_fill[e.from * alphabet.size() + e.symbol]++] = e.to;
+    }
+
+    //sorted rows make equal target sets compare equal
+    for (int i = 0; i < rows; i++) {
+        if (csr_offsets[i + 1] - csr_offsets[i] < 2) continue;
+        sort(csr_targets.begin() + csr_offsets[i], csr_targets.begin() + csr_offsets[i + 1]);
+    }
+}
+
+//two symbols are equivalent when every state has the same targets on both.
+//symbols are bucketed by a hash of their whole column of targets, and a
+//symbol joins a class only if its column really matches the class's first
+void NFA::build_symbol_classes() {
+    int k = alphabet.size();
+    auto same_column = [&](int a, int b) {
+        for (int state = 0; state < universe; state++) {
+            StateRange x = targets(state, a), y = targets(state, b);
+            if (x.size() != y.size() || !equal(x.begin(), x.end(), y.begin())) return false;
+        }
+        return true;
+    };
+
+    vector<uint64_t> column_hash(k, 0);
+    for (int a = 0; a < k; a++) {
+        uint64_t h = 0;
+        for (int state = 0; state < universe; state++) {
+            for (int target : targets(state, a)) {
+                h = (h ^ (uint64_t(state) << 32 | uint32_t(target))) * 0x100000001b3ull;
+            }
+            h = (h ^ 0xff) * 0x100000001b3ull; //row separator
+        }
+        column_hash[a] = h;
+    }
+
+    symbol_class.assign(k, -1);
+    class_symbol.clear();
+    unordered_map<uint64_t, vector<int>> classes_by_hash;
+    for (int a = 0; a < k; a++) {
+        vector<int> &candidates = classes_by_hash[column_hash[a]];
+        for (int c : candidates) {
+            if (same_column(class_symbol[c], a)) { symbol_class[a] = c; break; }
+        }
+        if (symbol_class[a] == -1) {
+            symbol_class[a] = class_symbol.size();
+            candidates.push_back(class_symbol.size());
+            class_symbol.push_back(a);
+        }
+    }
+
+    //multi-character symbols can't be matched byte by byte
+    for (int i = 0; i < 256; i++) byte_class[i] = -1;
+    for (int a = 0; a < k; a++) {
+        if (alphabet[a].size() == 1) byte_class[(unsigned char) alphabet[a][0]] = symbol_class[a];
+    }
+}
+
+//tarjan's algorithm over the epsilon edges, with an explicit call stack.
+//components come off in reverse topological order, so when one completes,
+//every component it can reach already has its closure. a component's closure 
+//is its own members plus the closures of the components its edges lead to.
+//a state's bookkeeping is kept together, since on a large nfa each visit is
+//a cache miss; a state is on the stack while it is visited but has no scc
+void NFA::build_epsilon_closures() {
+    closure_of.assign(universe, -1);
+    dense_closures = universe <= dense_closure_limit;
+    scc_closures.clear();
+    closure_offsets.assign(1, 0);
+    closure_members.clear();
+    //without epsilon edges every state is its own closure
+    if (eps_offsets[universe] == 0) return;
+
+    struct visit { int index = -1, lowlink = 0, scc = -1; };
+    vector<visit> visits(universe);
+    vector<int> scc_stack;
+    vector<pair<int, int>> call_stack; //(state, next epsilon edge)
+    vector<int> seen(dense_closures ? 0 : universe, -1); //closure last added to
+    vector<int> members;
+    int scc_count = 0;
+    int counter = 0;
+
+    for (int root = 0; root < universe; root++) {
+        if (visits[root].index != -1) continue;
+
+        call_stack.push_back({root, 0});
+        visits[root].index = visits[root].lowlink = counter++;
+        scc_stack.push_back(root);
+
+        while (!call_stack.empty()) {
+            int state = call_stack.back().first;
+            int &edge = call_stack.back().second;
+            StateRange targets = epsilon_targets(state);
+
+            if (edge < targets.size()) {
+                int next = targets.first[edge++];
+                visit &v = visits[next];
+                if (v.index == -1) {
+                    v.index = v.lowlink = counter++;
+                    scc_stack.push_back(next);
+                    call_stack.push_back({next, 0});
+                } else if (v.scc == -1) {
+                    visits[state].lowlink = min(visits[state].lowlink, v.index);
+                }
+                continue;
+            }
+
+            //every edge explored. if state is a component root, pop the component
+            if (visits[state].lowlink == visits[state].index) {
+                int scc = scc_count++;
+                members.clear();
+                int member;
+                do {
+                    member = scc_stack.back(); scc_stack.pop_back();
+                    visits[member].scc = scc;
+                    members.push_back(member);
+                } while (member != state);
+
+                //a lone state without epsilon transitions is its own closure
+                if (members.size() == 1 && epsilon_targets(state).size() == 0) {
+                    call_stack.pop_back();
+                    if (!call_stack.empty()) {
+                        int parent = call_stack.back().first;
+                        visits[parent].lowlink = min(visits[parent].lowlink, visits[state].lowlink);
+                    }
+                    continue;
+                }
+
+                int id = dense_closures ? scc_closures.size() : closure_offsets.size() - 1;
+                if (dense_closures) {
+                    StateSet closure(universe);
+                    for (int m : members) {
+                        closure.insert(m);
+                        for (int next : epsilon_targets(m)) {
+                            if (visits[next].scc != scc) add_epsilon_closure(next, closure);
+                        }
+                    }
+                    scc_closures.push_back(closure);
+                } else {
+                    size_t first = closure_members.size();
+                    auto add = [&](int member) {
+                        if (seen[member] == id) return;
+                        seen[member] = id;
+                        closure_members.push_back(member);
+                    };
+                    for (int m : members) {
+                        add(m);
+                        for (int next : epsilon_targets(m)) {
+                            if (visits[next].scc == scc) continue;
+                            int closure = closure_of[next];
+                            if (closure == -1) { add(next); continue; }
+                            for (int i = closure_offsets[closure]; i < closure_offsets[closure + 1]; i++) {
+                                add(closure_members[i]);
+                            }
+                        }
+                    }
+                    sort(closure_members.begin() + first, closure_members.end());
+                    closure_offsets.push_back(closure_members.size());
+                }
+                for (int m : members) closure_of[m] = id;
+            }
+
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                int parent = call_stack.back().first;
+                visits[parent].lowlink = min(visits[parent].lowlink, visits[state].lowlink);
+            }
+        }
+    }
+}
+
+//print out nfa for testing
+void NFA::print_out() const {
+    for(auto i : states) {
+        cout << state_names[i] << " ";
+    } cout << endl;
+
+    for(auto &i : alphabet) {
+        cout << i << " ";
+    } cout << endl;
+
+    cout << state_names[start_state] << endl;
+
+    for(auto i : accept_states) {
+        cout << state_names[i] << " ";
+    } cout << endl;
+
+    for(int i = 0; i < universe; i++) {
+        cout << state_names[i] << ": " << endl;
+        for (int a = 0; a < (int) alphabet.size(); a++) {
+            cout << "symbol: " << alphabet[a] << ": ";
+            for (int k : targets(i, a)) {
+                cout << state_names[k] << " ";
+            } cout << endl;
+        }
+        cout << "symbol: EPS: ";
+        for (int k : epsilon_targets(i)) {
+            cout << state_names[k] << " ";
+        } cout << endl;
+    }
+}
+
+//regex front end --------------------------------------------
+//regular expressions over single byte symbols: literals, \ escapes, [abc] 
+//and [a-z] classes, . for any symbol the pattern uses, grouping, |, *, + 
+//and ?. the alphabet is the symbols the pattern uses, in order of first
+//appearance. nodes are added children first, so a pass in index order
+//visits every subexpression before the one containing it
+struct regex_node {
+    enum kind_t { empty, literal, concat, alternate, star, plus, optional };
+    kind_t kind;
+    vector<int> symbols; //alphabet indices, for a literal
+    int left, right;     //children, -1 when unused
+    bool any;            //a . matching the whole alphabet
+};
+
+class RegexParser {
+    public:
+        RegexParser(const string &pattern);
+
+        vector<regex_node> nodes;
+        int root;
+        vector<string> alphabet;
+
+    private:
+        const string &pattern;
+        size_t pos;
+        int symbol_ids[256];
+
+        int parse_alternation();
+        int parse_concatenation();
+        int parse_repeat();
+        int parse_atom();
+        void parse_class(regex_node &node);
+        int add(regex_node::kind_t kind, int left = -1, int right = -1);
+        int symbol(unsigned char c);
+        [[noreturn]] void error(const string &what) const;
+};
+
+RegexParser::RegexParser(const string &pattern) : pattern(pattern), pos(0) {
+    for (int i = 0; i < 256; i++) symbol_ids[i] = -1;
+    root = parse_alternation();
+    if (pos < pattern.size()) error("unbalanced )");
+
+    //a . is every symbol, which is only known once the whole pattern is read
+    for (regex_node &node : nodes) {
+        if (!node.any) continue;
+        node.symbols.clear();
+        for (int a = 0; a < (int) alphabet.size(); a++) node.symbols.push_back(a);
+    }
+}
+
+void RegexParser::error(const string &what) const {
+    cerr << "regex column " << pos + 1 << ": " << what << endl;
+    exit(EXIT_FAILURE);
+}
+
+int RegexParser::add(regex_node::kind_t kind, int left, int right) {
+    nodes.push_back({kind, {}, left, right, false});
+    return nodes.size() - 1;
+}
+
+int RegexParser::symbol(unsigned char c) {
+    if (symbol_ids[c] == -1) {
+        symbol_ids[c] = alphabet.size();
+        alphabet.push_back(string(1, c));
+    }
+    return symbol_ids[c];
+}
+
+int RegexParser::parse_alternation() {
+    int node = parse_concatenation();
+    while (pos < pattern.size() && pattern[pos] == '|') {
+        pos++;
+        int right = parse_concatenation();
+        node = add(regex_node::alternate, node, right);
+    }
+    return node;
+}
+
+int RegexParser::parse_concatenation() {
+    int node = -1;
+    while (pos < pattern.size() && pattern[pos] != '|' && pattern[pos] != ')') {
+        int next = parse_repeat();
+        node = node == -1 ? next : add(regex_node::concat, node, next);
+    }
+    return node == -1 ? add(regex_node::empty) : node;
+}
+
+int RegexParser::parse_repeat() {
+    int node = parse_atom();
+    while (pos < pattern.size()) {
+        char c = pattern[pos];
+        if (c == '*') node = add(regex_node::star, node);
+        else if (c == '+') node = add(regex_node::plus, node);
+        else if (c == '?') node = add(regex_node::optional, node);
+        else break;
+        pos++;
+    }
+    return node;
+}
+
+int RegexParser::parse_atom() {
+    char c = pattern[pos++];
+    if (c == '(') {
+        int node = parse_alternation();
+        if (pos >= pattern.size() || pattern[pos] != ')') error("missing )");
+        pos++;
+        return node;
+    }
+    if (c == '*' || c == '+' || c == '?') error(string("nothing to repeat before ") + c);
+
+    int node = add(regex_node::literal);
+    if (c == '[') parse_class(nodes[node]);
+    else if (c == '.') nodes[node].any = true;
+    else if (c == '\\') {
+        if (pos >= pattern.size()) error("trailing \\");
+        nodes[node].symbols.push_back(symbol(pattern[pos++]));
+    } else {
+        nodes[node].symbols.push_back(symbol(c));
+    }
+    return node;
+}
+
+//the inside of [...], after the [
+void RegexParser::parse_class(regex_node &node) {
+    if (pos < pattern.size() && pattern[pos] == '^') error("negated classes are not supported");
+    vector<bool> seen(256, false);
+    auto take = [&]() {
+        if (pos >= pattern.size()) error("missing ]");
+        if (pattern[pos] == '\\' && pos + 1 < pattern.size()) pos++;
+        return (unsigned char) pattern[pos++];
+    };
+
+    while (pos < pattern.size() && pattern[pos] != ']') {
+        unsigned char low = take(), high = low;
+        if (pos + 1 < pattern.size() && pattern[pos] == '-' && pattern[pos + 1] != ']') {
+            pos++;
+            high = take();
+            if (high < low) error("backwards range");
+        }
+        for (int c = low; c <= high; c++) {
+            if (!seen[c]) node.symbols.push_back(symbol(c));
+            seen[c] = true;
+        }
+    }
+    if (pos >= pattern.size()) error("missing ]");
+    pos++;
+    if (node.symbols.empty()) error("empty class");
+}
+
+NFA NFA::from_regex(const string &pattern, bool thompson) {
+    auto begin = chrono::steady_clock::now();
+    RegexParser regex(pattern);
+    const vector<regex_node> &nodes = regex.nodes;
+
+    NFA nfa;
+    nfa.source = "regex";
+    nfa.alphabet = regex.alphabet;
+    auto add_state = [&]() {
+        nfa.states.push_back(nfa.state_names.size());
+        nfa.state_names.push_back(to_string(nfa.state_names.size()));
+        return nfa.states.back();
+    };
+
+    if (thompson) {
+        //a fragment per node, entered at first and left at second
+        vector<pair<int, int>> fragment(nodes.size());
+        for (int i = 0; i < (int) nodes.size(); i++) {
+            const regex_node &node = nodes[i];
+            pair<int, int> left = node.left == -1 ? pair<int, int>() : fragment[node.left];
+            pair<int, int> right = node.right == -1 ? pair<int, int>() : fragment[node.right];
+            if (node.kind == regex_node::concat) {
+                nfa.edges.push_back({left.second, epsilon, right.first});
+                fragment[i] = {left.first, right.second};
+                continue;
+            }
+
+            int in = add_state(), out = add_state();
+            fragment[i] = {in, out};
+            switch (node.kind) {
+                case regex_node::empty:
+                    nfa.edges.push_back({in, epsilon, out});
+                    break;
+                case regex_node::literal:
+                    for (int a : node.symbols) nfa.edges.push_back({in, a, out});
+                    break;
+                case regex_node::alternate:
+                    nfa.edges.push_back({in, epsilon, left.first});
+                    nfa.edges.push_back({in, epsilon, right.first});
+                    nfa.edges.push_back({left.second, epsilon, out});
+                    nfa.edges.push_back({right.second, epsilon, out});
+                    break;
+                default: //star, plus, optional
+                    nfa.edges.push_back({in, epsilon, left.first});
+                    nfa.edges.push_back({left.second, epsilon, out});
+                    if (node.kind != regex_node::plus) nfa.edges.push_back({in, epsilon, out});
+                    if (node.kind != regex_node::optional) {
+                        nfa.edges.push_back({left.second, epsilon, left.first});
+                    }
+                    break;
+            }
+        }
+        nfa.start_state = fragment[regex.root].first;
+        nfa.accept_states.push_back(fragment[regex.root].second);
+    } else {
+        //state 0 is the start and every literal is a position state.
+        //an edge into a position is labelled with the position's symbols
+        add_state();
+        vector<int> position(nodes.size(), -1);
+        for (int i = 0; i < (int) nodes.size(); i++) {
+            if (nodes[i].kind == regex_node::literal) position[i] = add_state();
+        }
+        vector<const vector<int>*> symbols_of(nfa.state_names.size());
+        for (int i = 0; i < (int) nodes.size(); i++) {
+            if (position[i] != -1) symbols_of[position[i]] = &nodes[i].symbols;
+        }
+
+        //nullable, first and last position sets of every node, and the
+        //positions that can follow each position
+        vector<bool> nullable(nodes.size());
+        vector<vector<int>> first(nodes.size()), last(nodes.size());
+        vector<vector<int>> follow(nfa.state_names.size());
+        auto append = [](vector<int> &to, const vector<int> &from) {
+            to.insert(to.end(), from.begin(), from.end());
+        };
+        for (int i = 0; i < (int) nodes.size(); i++) {
+            const regex_node &node = nodes[i];
+            int l = node.left, r = node.right;
+            switch (node.kind) {
+                case regex_node::empty:
+                    nullable[i] = true;
+                    break;
+                case regex_node::literal:
+                    nullable[i] = false;
+                    first[i] = last[i] = {position[i]};
+                    break;
+                case regex_node::concat:
+                    nullable[i] = nullable[l] && nullable[r];
+                    for (int x : last[l]) append(follow[x], first[r]);
+                    first[i] = first[l];
+                    if (nullable[l]) append(first[i], first[r]);
+                    last[i] = last[r];
+                    if (nullable[r]) append(last[i], last[l]);
+                    break;
+                case regex_node::alternate:
+                    nullable[i] = nullable[l] || nullable[r];
+                    first[i] = first[l];
+                    append(first[i], first[r]);
+                    last[i] = last[l];
+                    append(last[i], last[r]);
+                    break;
+                default: //star, plus, optional
+                    nullable[i] = node.kind == regex_node::plus ? nullable[l] : true;
+                    if (node.kind != regex_node::optional) {
+                        for (int x : last[l]) append(follow[x], first[l]);
+                    }
+                    first[i] = first[l];
+                    last[i] = last[l];
+                    break;
+            }
+        }
+
+        follow[0] = first[regex.root];
+        for (int from = 0; from < (int) follow.size(); from++) {
+            vector<int> &next = follow[from];
+            sort(next.begin(), next.end());
+            next.erase(unique(next.begin(), next.end()), next.end());
+            for (int to : next) {
+                for (int a : *symbols_of[to]) nfa.edges.push_back({from, a, to});
+            }
+        }
+        nfa.start_state = 0;
+        if (nullable[regex.root]) nfa.accept_states.push_back(0);
+        append(nfa.accept_states, last[regex.root]);
+    }
+    auto parsed = chrono::steady_clock::now();
+
+    nfa.build_indexes();
+
+    nfa.parse_seconds = chrono::duration<double>(parsed - begin).count();
+    nfa.closure_seconds = chrono::duration<double>(chrono::steady_clock::now() - parsed).count();
+    return nfa;
+}
+
+//dfa class (5-tuple) ---------------------------------------
+//order in which the subset construction explores newly discovered states.
+//either way, ids are handed out in discovery order, so numbering and output
+//are the same from run to run
+enum class ExploreOrder { depth_first, breadth_first };
+
+//the two kinds of matcher print_header can generate. table is a constexpr
+//transition table walked by a constexpr function, goto is direct threaded
+//code with a label per state and a switch on each byte
+enum class HeaderStyle { table, goto_switch };
+
+//bounds on one subset construction. zero means no bound. bytes are the 
+//estimated storage for subsets, transition rows and the interning table
+struct ConversionLimits {
+    int max_states = 0;
+    size_t max_bytes = 0;
+    double max_seconds = 0;
+};
+
+//how a subset construction ended. anything but complete means it stopped
+//at a limit and the dfa is unfinished: states holds what was discovered
+enum class ConversionStatus { complete, state_limit, memory_limit, time_limit };
+struct ConversionResult {
+    ConversionStatus status = ConversionStatus::complete;
+    int states = 0;
+    size_t bytes = 0;
+    double seconds = 0;
+
+    const char* status_name() const {
+        switch (status) {
+            case ConversionStatus::state_limit: return "state_limit";
+            case ConversionStatus::memory_limit: return "memory_limit";
+            case ConversionStatus::time_limit: return "time_limit";
+            default: return "complete";
+        }
+    }
+};
+
+//what DFA::update did: states whose rows carried over, states explored 
+//again or for the first time, and states dropped as unreachable
+struct UpdateResult {
+    int reused = 0;
+    int explored = 0;
+    int collected = 0;
+};
+
+class DFA {
+    friend class CompiledDFA;
+
+    //all dfa_states are subsets of nfa states, stored as bitsets. a bit per
+    //nfa state avoids duplicates, membership is a single word test, and 
+    //comparing two states with == is a word-wise compare
+    typedef StateSet dfa_state;
+
+    private:
+        //the 5-tuple, including the nfa accept states so we can call on them later.
+        //states are interned once in subsets; everything else holds their ids
+        SubsetTable subsets;
+        vector<int> states;
+        vector<string> alphabet;
+        vector<string> state_names; //nfa state labels, for printing
+        vector<int> symbol_class; //alphabet index -> symbol class
+        int class_count;
+        int byte_class[256];
+        int universe; //one past the largest nfa state number
+        dfa_state nfa_accept_states;
+        int start_state;
+        vector<int> accept_states;
+        //[state id][symbol class] -> state id. each row is class_count ints 
+        //out of rows, so the whole table goes in one step with the dfa
+        vector<int*> transitions;
+        Arena rows;
+
+        //scratch space reused for every processed state
+        vector<dfa_state> process_state_mappings;
+
+        ExploreOrder order;
+        bool minimized = false;
+        ConversionLimits limits;
+        ConversionResult outcome;
+        chrono::steady_clock::time_point started;
+        //estimated bytes held for state_count states
+        size_t estimated_bytes(int state_count) const;
+        //the limit state_count states break, or complete. safe from any thread
+        ConversionStatus check_limits(int state_count) const;
+
+        //acquire dfa start state (epsilon check nfa start state)
+        void get_start_state(const NFA &nfa);
+        //runs the worklist until every reachable state has been processed.
+        //expand(id) fills in transitions[id], interning any new end states
+        template<class Expand> 
+        void run_worklist(ExploreOrder order, Expand expand);
+        //the end state of subset on every symbol, written into mappings
+        void compute_mappings(StateSetRef subset, const NFA &nfa,
+                              vector<dfa_state> &mappings) const;
+        //fill in the transitions of one state
+        void generate_transitions (int process_id, const NFA &nfa);
+        //renumber states in discovery order, dropping unreachable subsets
+        void renumber();
+        //build the transitions on several threads, then renumber them as the
+        //single threaded worklist would have
+        void generate_transitions_parallel(const NFA &nfa, ExploreOrder order, 
+                                           int thread_count);
+        
+        //functions for printing: the name of a subset, {EM} when empty
+        void append_subset(int id, string &out) const;
+        string string_subset(int id) const;
+
+    public:
+        DFA(const NFA &nfa, ExploreOrder order = ExploreOrder::depth_first, 
+            int thread_count = 1, const ConversionLimits &limits = ConversionLimits());
+        //how construction ended. an unfinished dfa must not be minimized,
+        //printed or compiled
+        const ConversionResult& result() const { return outcome; }
+        bool complete() const { return outcome.status == ConversionStatus::complete; }
+        //merge equivalent states (hopcroft's partition refinement)
+        void minimize();
+        //bring a complete, unminimized dfa up to date with nfa after 
+        //NFA::apply, which gave touched. existing states keep their ids
+        //unless renumber_states is set, which then numbers states as a 
+        //fresh conversion would and frees unreachable ones
+        UpdateResult update(const NFA &nfa, const StateSet &touched, bool renumber_states = false);
+        void print_to_file(string file_name) const;
+        //write the compiled table as a binary .dfab file, with a dictionary
+        //of the alphabet and state names
+        void print_binary(string file_name) const;
+        //write a c++ header matching what the dfa accepts (CompiledDFA::print_header)
+        void print_header(string file_name, const string &name, HeaderStyle style) const;
+        int state_count() const { return states.size(); }
+        //one transition per state and symbol
+        long transition_count() const { return (long) states.size() * alphabet.size(); }
+
+        //walk the dfa a symbol (alphabet index) at a time, for checking it
+        int start() const { return start_state; }
+        int next(int state, int symbol) const { return transitions[state][symbol_class[symbol]]; }
+        const vector<int>& accepting() const { return accept_states; }
+        int id_count() const { return transitions.size(); }
+};
+
+//create the dfa -- based around the 5-tuple. the states are created along
+//with transitions
+DFA::DFA(const NFA &nfa, ExploreOrder order, int thread_count, const ConversionLimits &limits) 
+    : order(order), limits(limits), started(chrono::steady_clock::now()) {
+    universe = nfa.universe;
+    nfa_accept_states = dfa_state(universe);
+    for (int state : nfa.accept_states) nfa_accept_states.insert(state);
+
+    alphabet = nfa.alphabet; 
+    state_names = nfa.state_names;
+    symbol_class = nfa.symbol_class;
+    class_count = nfa.class_count();
+    copy(nfa.byte_class, nfa.byte_class + 256, byte_class);
+    if (thread_count > 1) {
+        generate_transitions_parallel(nfa, order, thread_count);
+    } else {
+        get_start_state(nfa);
+        process_state_mappings.assign(class_count, dfa_state(universe));
+        run_worklist(order, [&](int process_id) { generate_transitions(process_id, nfa); });
+    }
+
+    if (complete()) outcome.states = states.size();
+    outcome.bytes = estimated_bytes(outcome.states);
+    outcome.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+}
+
+size_t DFA::estimated_bytes(int state_count) const {
+    size_t words = (universe + 63) / 64;
+    size_t per_state = words * sizeof(uint64_t) + class_count * sizeof(int) 
+                     + sizeof(uint64_t*) + sizeof(int*) + sizeof(uint64_t) + 2 * sizeof(int);
+    return state_count * per_state;
+}
+
+ConversionStatus DFA::check_limits(int state_count) const {
+    if (limits.max_states > 0 && state_count > limits.max_states) return ConversionStatus::state_limit;
+    if (limits.max_bytes > 0 && estimated_bytes(state_count) > limits.max_bytes) {
+        return ConversionStatus::memory_limit;
+    }
+    if (limits.max_seconds > 0) {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - started;
+        if (elapsed.count() > limits.max_seconds) return ConversionStatus::time_limit;
+    }
+    return ConversionStatus::complete;
+}
+
+//the start the state is the nfa start state, with epsilon checking
+void DFA::get_start_state(const NFA &nfa) {
+    dfa_state start(universe);
+    nfa.add_epsilon_closure(nfa.start_state, start);
+
+    bool inserted;
+    start_state = subsets.intern(start, inserted);
+}
+
+//process states off an explicit worklist instead of recursing. depth first
+//uses it as a stack, breadth first as a queue. depth first pushes newly
+//discovered states in reverse, so they are visited in symbol order
+template<class Expand>
+void DFA::run_worklist (ExploreOrder order, Expand expand) {
+    vector<int> worklist; size_t head = 0;
+    worklist.push_back(start_state);
+
+    while (head < worklist.size()) {
+        int process_id;
+        if (order == ExploreOrder::breadth_first) {
+            process_id = worklist[head++];
+        } else {
+            process_id = worklist.back();
+            worklist.pop_back();
+        }
+
+        states.push_back(process_id); //push the state to the overall dfa state list
+        STAT_MAX(peak_subset, subsets.subset(process_id).size());
+
+        //a dfa state is an accept state if it contains any nfa accept state
+        if (subsets.subset(process_id).intersects(nfa_accept_states)) {
+            accept_states.push_back(process_id);
+        }
+
+        int first_new = subsets.size();
+        if ((int) transitions.size() <= process_id) transitions.resize(process_id + 1, nullptr);
+        expand(process_id);
+
+        outcome.status = check_limits(subsets.size());
+        if (!complete()) {
+            outcome.states = subsets.size();
+            return;
+        }
+
+        //anything with an id past first_new was discovered by this state.
+        //ids were handed out in symbol order
+        if (order == ExploreOrder::breadth_first) {
+            for (int id = first_new; id < subsets.size(); id++) worklist.push_back(id);
+        } else {
+            for (int id = subsets.size() - 1; id >= first_new; id--) worklist.push_back(id);
+        }
+    }
+}
+
+//go through the character mappings for each state
+//add the precomputed epsilon closures of their targets to the map.
+//bitset iteration visits each member exactly once, so no duplicate checks.
+//equivalent symbols lead to the same place, so only one per class is tried
+void DFA::compute_mappings (StateSetRef subset, const NFA &nfa, 
+                            vector<dfa_state> &mappings) const {
+    for (auto &mapping : mappings) mapping.clear();
+
+    subset.for_each([&](int member) {
+        for (int c = 0; c < class_count; c++) {
+            for (int state : nfa.targets(member, nfa.class_symbol[c])) { //for states associated with char
+                nfa.add_epsilon_closure(state, mappings[c]);
+            }
+        }
+    });
+}
+
+//generate transitions for a dfa state. end states that haven't been seen
+//before are interned (and given the next ids) in symbol order
+void DFA::generate_transitions (int process_id, const NFA &nfa) {
+    compute_mappings(subsets.subset(process_id), nfa, process_state_mappings);
+
+    //an update recomputing a row writes over the old one
+    int* row = transitions[process_id];
+    if (row == nullptr) row = transitions[process_id] = rows.allocate<int>(class_count);
+    for (int c = 0; c < class_count; c++) {
+        bool inserted;
+        row[c] = subsets.intern(process_state_mappings[c], inserted);
+    }
+}
+
+//level synchronous breadth first construction. each level's frontier is 
+//split into small chunks that idle threads claim off an atomic cursor, so
+//a thread that finishes early takes on more of the level instead of waiting.
+//new subsets go through a sharded concurrent table and carry provisional 
+//ids, which depend on thread timing. once everything is built, the finished
+//graph is walked with the ordinary worklist to give every state the id the
+//single threaded construction would have, so the output is identical. that
+//walk only maps ids: the subsets stay where the shards stored them, and each
+//thread's rows, out of its own arena, are rewritten in place. the frontier
+//refers to subsets by id and a view of the shard's copy
+void DFA::generate_transitions_parallel (const NFA &nfa, ExploreOrder order, 
+                                         int thread_count) {
+    const size_t chunk = 16;
+    //threads past the core count only take turns, so the pool is no bigger
+    //than the machine; on a single core the main thread does every level
+    thread_count = min(thread_count, max(1, (int) thread::hardware_concurrency()));
+    ConcurrentSubsetTable table;
+    vector<int*> provisional_rows; //provisional id -> provisional end states
+    vector<Arena> row_arenas(thread_count);
+
+    bool inserted;
+    dfa_state start(universe);
+    nfa.add_epsilon_closure(nfa.start_state, start);
+    StateSetRef stored = start;
+    vector<pair<int, StateSetRef>> frontier;
+    int start_id = table.intern(start, inserted, stored);
+    frontier.push_back({start_id, stored});
+
+    vector<vector<pair<int, StateSetRef>>> discovered(thread_count);
+    atomic<size_t> cursor(0);
+    atomic<int> stopped((int) ConversionStatus::complete);
+
+    //claim chunks of the frontier until it runs out
+    auto drain = [&](int thread_id, vector<dfa_state> &mappings) {
+        size_t begin;
+        while (stopped.load(memory_order_relaxed) == (int) ConversionStatus::complete
+               && (begin = cursor.fetch_add(chunk)) < frontier.size()) {
+            size_t end = min(frontier.size(), begin + chunk);
+            for (size_t i = begin; i < end; i++) {
+                compute_mappings(frontier[i].second, nfa, mappings);
+
+                int* row = row_arenas[thread_id].allocate<int>(class_count);
+                for (int c = 0; c < class_count; c++) {
+                    bool is_new;
+                    StateSetRef target = mappings[c];
+                    row[c] = table.intern(mappings[c], is_new, target);
+                    if (is_new) discovered[thread_id].push_back({row[c], target});
+                }
+                provisional_rows[frontier[i].first] = row;
+            }
+            ConversionStatus status = check_limits(table.size());
+            if (status != ConversionStatus::complete) stopped = (int) status;
+        }
+    };
+
+    //one pool for the whole construction. for each level the main thread
+    //publishes the frontier and bumps level, then drains it alongside the
+    //pool, and the last pool thread done wakes it. a frontier too small to
+    //give every thread a chunk is drained by the main thread alone
+    const size_t min_parallel_frontier = chunk * thread_count;
+    mutex level_lock;
+    condition_variable level_ready, level_done;
+    int level = 0;  //bumped each time a frontier is published
+    int busy = 0;   //pool threads still draining it
+    bool finished = false;
+
+    vector<thread> pool;
+    for (int t = 1; t < thread_count; t++) {
+        pool.emplace_back([&, t]() {
+            vector<dfa_state> mappings(class_count, dfa_state(universe));
+            int seen = 0;
+            while (true) {
+                {
+                    unique_lock<mutex> lock(level_lock);
+                    level_ready.wait(lock, [&]() { return finished || level != seen; });
+                    if (finished) break;
+                    seen = level;
+                }
+                drain(t, mappings);
+                lock_guard<mutex> lock(level_lock);
+                if (--busy == 0) level_done.notify_one();
+            }
+            STAT_MERGE();
+        });
+    }
+    auto shut_down = [&]() {
+        {
+            lock_guard<mutex> lock(level_lock);
+            finished = true;
+        }
+        level_ready.notify_all();
+        for (auto &t : pool) t.join();
+    };
+
+    vector<dfa_state> mappings(class_count, dfa_state(universe));
+    while (!frontier.empty()) {
+        provisional_rows.resize(table.size());
+        cursor = 0;
+
+        if (pool.empty() || frontier.size() < min_parallel_frontier) drain(0, mappings);
+        else {
+            {
+                lock_guard<mutex> lock(level_lock);
+                busy = thread_count - 1;
+                level++;
+            }
+            level_ready.notify_all();
+            drain(0, mappings);
+            unique_lock<mutex> lock(level_lock);
+            level_done.wait(lock, [&]() { return busy == 0; });
+        }
+
+        //stopped at a limit, leaving the dfa unfinished
+        outcome.status = (ConversionStatus) stopped.load();
+        if (!complete()) {
+            shut_down();
+            outcome.states = table.size();
+            return;
+        }
+
+        frontier.clear();
+        for (auto &found : discovered) {
+            frontier.insert(frontier.end(), found.begin(), found.end());
+            found.clear();
+        }
+    }
+    shut_down();
+
+    //canonical renumbering. canonical[p] is the final id of provisional id p.
+    //every subset is already unique and hashed, so it is appended as is
+    table.index_ids();
+    vector<int> canonical(table.size(), -1);
+    vector<int> provisional; //final id -> provisional id
+    start_state = subsets.append(table.subset(0), table.hash(0));
+    canonical[0] = start_state;
+    provisional.push_back(0);
+
+    run_worklist(order, [&](int process_id) {
+        int* row = transitions[process_id] = provisional_rows[provisional[process_id]];
+        for (int c = 0; c < class_count; c++) {
+            int target = row[c];
+            if (canonical[target] == -1) {
+                canonical[target] = subsets.append(table.subset(target), table.hash(target));
+                provisional.push_back(target);
+            }
+            row[c] = canonical[target];
+        }
+    });
+    table.move_storage_into(subsets);
+    for (auto &arena : row_arenas) rows.adopt(arena);
+}
+
+//hopcroft's algorithm. the partition is kept as a permutation of the states
+//in which every block is a contiguous range, so marking a state is one swap
+//and splitting a block is moving its boundary. the worklist holds 
+//(block, symbol) splitters; when a block splits, a splitter already pending
+//for it is extended to both halves, otherwise only the smaller half is
+//added, which gives the O(n k log n) bound
+void DFA::minimize() {
+    //partitioning indexes states by id, which an update can leave sparse
+    if ((int) states.size() != subsets.size()) renumber();
+    int n = states.size();
+    int k = class_count;
+    if (n == 0) return;
+    minimized = true;
+
+    //the transitions reversed, per symbol: sources of (symbol, target) are
+    //inverse_sources[inverse_offsets[symbol * n + target] ...]
+    vector<int> inverse_offsets(k * n + 1, 0);
+    vector<int> inverse_sources(n * k);
+    for (int q = 0; q < n; q++) {
+        for (int a = 0; a < k; a++) inverse_offsets[a * n + transitions[q][a] + 1]++;
+    }
+    for (int i = 0; i < k * n; i++) inverse_offsets[i + 1] += inverse_offsets[i];
+    vector<int> fill(inverse_offsets.begin(), inverse_offsets.end() - 1);
+    for (int q = 0; q < n; q++) {
+        for (int a = 0; a < k; a++) inverse_sources[fill[a * n + transitions[q][a]]++] = q;
+    }
+
+    //partition. block b is elements[first[b], past[b]); its marked states
+    //sit at the front, in [first[b], marked_end[b])
+    vector<int> elements(n), location(n), block_of(n);
+    vector<int> first, past, marked_end;
+    vector<bool> accepting(n, false);
+    for (int q : accept_states) accepting[q] = true;
+
+    int position = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        int begin = position;
+        for (int q = 0; q < n; q++) {
+            if (accepting[q] != (pass == 0)) continue;
+            elements[position] = q; location[q] = position++;
+            block_of[q] = first.size();
+        }
+        if (position > begin) {
+            first.push_back(begin); past.push_back(position); marked_end.push_back(begin);
+        }
+    }
+
+    vector<bool> pending; //[block * k + symbol] is in the worklist
+    vector<pair<int, int>> worklist;
+    auto add_splitter = [&](int block, int symbol) {
+        if ((int) pending.size() < (block + 1) * k) pending.resize((block + 1) * k, false);
+        if (pending[block * k + symbol]) return;
+        pending[block * k + symbol] = true;
+        worklist.push_back({block, symbol});
+    };
+
+    int smallest = 0;
+    for (int b = 1; b < (int) first.size(); b++) {
+        if (past[b] - first[b] < past[smallest] - first[smallest]) smallest = b;
+    }
+    for (int a = 0; a < k; a++) add_splitter(smallest, a);
+
+    vector<int> predecessors, touched;
+    while (!worklist.empty()) {
+        int splitter = worklist.back().first, symbol = worklist.back().second;
+        worklist.pop_back();
+        pending[splitter * k + symbol] = false;
+
+        //gather first, since the splitter itself may be split below
+        predecessors.clear();
+        for (int i = first[splitter]; i < past[splitter]; i++) {
+            int target = elements[i];
+            for (int j = inverse_offsets[symbol * n + target]; 
+                 j < inverse_offsets[symbol * n + target + 1]; j++) {
+                predecessors.push_back(inverse_sources[j]);
+            }
+        }
+
+        touched.clear();
+        for (int q : predecessors) {
+            int b = block_of[q];
+            if (location[q] < marked_end[b]) continue; //already marked
+            if (marked_end[b] == first[b]) touched.push_back(b);
+            int other = elements[marked_end[b]];
+            swap(elements[location[q]], elements[marked_end[b]]);
+            location[other] = location[q];
+            location[q] = marked_end[b]++;
+        }
+
+        for (int b : touched) {
+            if (marked_end[b] == past[b]) { //every state marked, nothing to split
+                marked_end[b] = first[b];
+                continue;
+            }
+
+            //the marked states become a new block
+            int split = first.size();
+            first.push_back(first[b]); past.push_back(marked_end[b]); 
+            marked_end.push_back(first[b]);
+            first[b] = marked_end[b];
+            for (int i = first[split]; i < past[split]; i++) block_of[elements[i]] = split;
+
+            int smaller = (past[split] - first[split] < past[b] - first[b]) ? split : b;
+            for (int a = 0; a < k; a++) {
+                if ((int) pending.size() > b * k + a && pending[b * k + a]) add_splitter(split, a);
+                else add_splitter(smaller, a);
+            }
+        }
+    }
+
+    //blocks become the new states, numbered in the order their first member
+    //appears in states. a block is labelled with that member's subset
+    vector<int> new_id(first.size(), -1), representative;
+    for (int q : states) {
+        if (new_id[block_of[q]] != -1) continue;
+        new_id[block_of[q]] = representative.size();
+        representative.push_back(q);
+    }
+
+    SubsetTable merged;
+    Arena merged_rows;
+    vector<int*> merged_transitions(representative.size());
+    vector<int> merged_accepts;
+    for (int id = 0; id < (int) representative.size(); id++) {
+        int q = representative[id];
+        bool inserted;
+        merged.intern(subsets.subset(q), inserted);
+        merged_transitions[id] = merged_rows.allocate<int>(k);
+        for (int a = 0; a < k; a++) {
+            merged_transitions[id][a] = new_id[block_of[transitions[q][a]]];
+        }
+        if (accepting[q]) merged_accepts.push_back(id);
+    }
+
+    start_state = new_id[block_of[start_state]];
+    subsets = move(merged);
+    rows = move(merged_rows);
+    transitions = move(merged_transitions);
+    accept_states = move(merged_accepts);
+    states.resize(representative.size());
+    for (int id = 0; id < (int) states.size(); id++) states[id] = id;
+}
+
+//ids and rows stay where they are. the nfa fields are brought up to date
+//(widening every subset if the nfa grew a word, and relaying rows if 
+//symbol classes split or merged), then one walk from the new start state
+//finds what is still reachable. a row is recomputed only when its subset
+//has a touched member, or the state is new, or it had been dropped by an
+//earlier update; any other row still holds. states the walk doesn't reach
+//leave states and accept_states, but stay interned until renumber
+UpdateResult DFA::update(const NFA &nfa, const StateSet &touched, bool renumber_states) {
+    if (minimized || !complete()) {
+        cerr << "only a complete, unminimized dfa can be updated" << endl;
+        exit(EXIT_FAILURE);
+    }
+    started = chrono::steady_clock::now();
+
+    if ((nfa.universe + 63) / 64 != (universe + 63) / 64) {
+        int old_words = (universe + 63) / 64;
+        SubsetTable wider;
+        dfa_state wide(nfa.universe);
+        for (int id = 0; id < subsets.size(); id++) {
+            wide.clear();
+            copy(subsets.subset(id).words(), subsets.subset(id).words() + old_words, wide.words());
+            bool inserted;
+            wider.intern(wide, inserted);
+        }
+        subsets = move(wider);
+    }
+
+    bool same_classes = nfa.symbol_class == symbol_class;
+    if (!same_classes) {
+        vector<int> old_class(nfa.class_count());
+        for (int c = 0; c < nfa.class_count(); c++) old_class[c] = symbol_class[nfa.class_symbol[c]];
+        Arena relaid;
+        for (int*& row : transitions) {
+            if (row == nullptr) continue;
+            int* next = relaid.allocate<int>(old_class.size());
+            for (size_t c = 0; c < old_class.size(); c++) next[c] = row[old_class[c]];
+            row = next;
+        }
+        rows = move(relaid);
+    }
+
+    universe = nfa.universe;
+    nfa_accept_states = dfa_state(universe);
+    for (int state : nfa.accept_states) nfa_accept_states.insert(state);
+    state_names = nfa.state_names;
+    symbol_class = nfa.symbol_class;
+    class_count = nfa.class_count();
+    copy(nfa.byte_class, nfa.byte_class + 256, byte_class);
+    process_state_mappings.assign(class_count, dfa_state(universe));
+
+    //a row holds if its state was live before and no member was touched
+    vector<bool> holds(subsets.size(), false);
+    for (int id : states) holds[id] = !subsets.subset(id).intersects(touched);
+    int old_count = states.size();
+    vector<int> old_states = move(states);
+
+    UpdateResult update;
+    get_start_state(nfa);
+    vector<bool> reached(subsets.size(), false);
+    vector<int> walk = {start_state};
+    reached[start_state] = true;
+    for (size_t i = 0; i < walk.size(); i++) {
+        int id = walk[i];
+        if (id < (int) holds.size() && holds[id]) update.reused++;
+        else {
+            if ((int) transitions.size() <= id) transitions.resize(id + 1, nullptr);
+            generate_transitions(id, nfa);
+            update.explored++;
+            outcome.status = check_limits(subsets.size());
+            if (!complete()) {
+                outcome.states = subsets.size();
+                return update;
+            }
+            if ((int) reached.size() < subsets.size()) reached.resize(subsets.size(), false);
+        }
+        for (int c = 0; c < class_count; c++) {
+            int next = transitions[id][c];
+            if (!reached[next]) {
+                reached[next] = true;
+                walk.push_back(next);
+            }
+        }
+    }
+
+    //states keep their order, with new (or revived) ones after them by id
+    for (int id : old_states) {
+        if (reached[id]) {
+            states.push_back(id);
+            reached[id] = false;
+        }
+    }
+    update.collected = old_count - states.size();
+    for (int id = 0; id < (int) reached.size(); id++) {
+        if (reached[id]) states.push_back(id);
+    }
+    accept_states.clear();
+    for (int id : states) {
+        if (subsets.subset(id).intersects(nfa_accept_states)) accept_states.push_back(id);
+    }
+    if (renumber_states) renumber();
+
+    outcome.states = states.size();
+    outcome.bytes = estimated_bytes(outcome.states);
+    outcome.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return update;
+}
+
+//give states the ids a fresh construction in order would, and keep only
+//reachable subsets and rows. this walks the finished graph the way 
+//run_worklist walks the nfa: a target gets the next id when first seen
+void DFA::renumber() {
+    vector<int> new_id(subsets.size(), -1);
+    vector<int> by_new_id = {start_state};
+    new_id[start_state] = 0;
+    vector<int> order_of_processing;
+    vector<int> worklist = {start_state};
+    size_t head = 0;
+    while (head < worklist.size()) {
+        int id;
+        if (order == ExploreOrder::breadth_first) id = worklist[head++];
+        else {
+            id = worklist.back();
+            worklist.pop_back();
+        }
+        order_of_processing.push_back(id);
+        int first_new = by_new_id.size();
+        for (int c = 0; c < class_count; c++) {
+            int next = transitions[id][c];
+            if (new_id[next] == -1) {
+                new_id[next] = by_new_id.size();
+                by_new_id.push_back(next);
+            }
+        }
+        if (order == ExploreOrder::breadth_first) {
+            for (int i = first_new; i < (int) by_new_id.size(); i++) worklist.push_back(by_new_id[i]);
+        } else {
+            for (int i = by_new_id.size() - 1; i >= first_new; i--) worklist.push_back(by_new_id[i]);
+        }
+    }
+
+    SubsetTable renumbered;
+    Arena renumbered_rows;
+    vector<int*> renumbered_transitions(by_new_id.size());
+    for (int id = 0; id < (int) by_new_id.size(); id++) {
+        bool inserted;
+        renumbered.intern(subsets.subset(by_new_id[id]), inserted);
+        int* row = renumbered_transitions[id] = renumbered_rows.allocate<int>(class_count);
+        for (int c = 0; c < class_count; c++) row[c] = new_id[transitions[by_new_id[id]][c]];
+    }
+    vector<bool> accepting(new_id.size(), false);
+    for (int id : accept_states) accepting[id] = true;
+
+    states.clear();
+    accept_states.clear();
+    for (int id : order_of_processing) {
+        states.push_back(new_id[id]);
+        if (accepting[id]) accept_states.push_back(new_id[id]);
+    }
+    start_state = 0;
+    subsets = move(renumbered);
+    rows = move(renumbered_rows);
+    transitions = move(renumbered_transitions);
+}
+
+//a function for printing a dfa to a file. every subset name is printed
+//once per symbol plus once in the state list, so each is rendered once up
+//front and then copied into a buffered writer, one line per transition
+void DFA::print_to_file(string file_name) const {
+    string names;
+    vector<size_t> name_offsets(subsets.size() + 1);
+    for (int id = 0; id < subsets.size(); id++) {
+        name_offsets[id] = names.size();
+        append_subset(id, names);
+    }
+    name_offsets[subsets.size()] = names.size();
+    auto name = [&](int id) {
+        return string_view(names.data() + name_offsets[id], name_offsets[id + 1] - name_offsets[id]);
+    };
+
+    BufferedWriter out(file_name + ".dfa");
+
+    //list of states
+    for (int state : states) {
+        out.write(name(state));
+        out.put(' ');
+    }
+    out.put('\n');
+    //list of symbols
+    for (const string &symbol : alphabet) {
+        out.write(symbol);
+        out.put('\t');
+    }
+    out.put('\n');
+    //start states
+    out.write(name(start_state));
+    out.put('\n');
+    //valid accept states
+    for (int state : accept_states) {
+        if (!subsets.subset(state).empty()) {
+            out.write(name(state));
+            out.put(' ');
+        }
+    }
+    out.put('\n');
+    //transition function
+    for (int state : states) {
+        const int* row = transitions[state];
+        for (int a = 0; a < (int) alphabet.size(); a++) {
+            out.write(name(state));
+            out.write(", ");
+            out.write(alphabet[a]);
+            out.write(" = ");
+            out.write(name(row[symbol_class[a]]));
+            out.write(" \n");
+        }
+    }
+}
+
+//helper function to stringify a single subset, {EM} for the empty set
+void DFA::append_subset(int id, string &out) const {
+    StateSetRef state = subsets.subset(id);
+    if (state.empty()) {
+        out += "{EM}";
+        return;
+    }
+
+    out += '{';
+    state.for_each([&](int member) {
+        out += state_names[member];
+        out += ',';
+    });
+    out[out.size() - 1] = '}';
+}
+
+string DFA::string_subset(int id) const {
+    string power_rep;
+    append_subset(id, power_rep);
+    return power_rep;
+}
+
+//compiled dfa class ----------------------------------------
+//a dfa flattened into one uint32_t table with a row per state and a column
+//per symbol class, plus one column for bytes outside the alphabet. input 
+//bytes go through a 256 entry byte -> column lookup. entries hold the target
+//row already multiplied by the row width, so a step is
+//state = table[state + column[byte]]. the extra column leads to an extra
+//rejecting sink state, and accept states are a bitmap over rows.
+//
+//the same arrays can be saved as a binary .dfab file and mapped straight
+//back in: the file is a header followed by the column map, the table, the
+//accept bitmap and an optional dictionary of symbol and state names, each
+//8 byte aligned. loading checks the header and section bounds and points 
+//into the mapping, so any number of processes share one read only copy of
+//the table, and startup doesn't depend on its size. checking every table
+//entry touches every page, so it is only done when asked for
+class CompiledDFA {
+    public:
+        CompiledDFA(const DFA &dfa);
+        //map a binary file written by save. with check_table, every entry
+        //is checked to lead to a row of the table as well
+        CompiledDFA(const string &binary_file, bool check_table = false);
+        //map a binary file as the constructor does, but return null with 
+        //the reason in error, rather than exiting, if it isn't valid
+        static unique_ptr<CompiledDFA> load(const string &binary_file, string &error, 
+                                            bool check_table = false);
+        CompiledDFA(const CompiledDFA&) = delete;
+        CompiledDFA& operator=(const CompiledDFA&) = delete;
+
+        //does the dfa accept the bytes in [begin, end)
+        bool matches(const char* begin, const char* end) const {
+            const uint32_t* t = table;
+            uint32_t state = start;
+            for (const unsigned char* c = (const unsigned char*) begin; 
+                 c != (const unsigned char*) end; c++) {
+                state = t[state + column[*c]];
+            }
+            return accepts(state);
+        }
+
+        //match many independent inputs at once. batch_lanes inputs are walked
+        //through the table in lockstep, so their loads overlap instead of
+        //each waiting on the last. results[i] is 1 if inputs[i] is accepted
+        static const int batch_lanes = 16;
+        void match_batch(const string_view* inputs, size_t count, uint8_t* results) const;
+
+        int state_count() const { return rows; }
+
+        //walk the table a byte at a time by row number, for checking it
+        int start_row() const { return start / width; }
+        int next_row(int row, unsigned char byte) const { return table[row * width + column[byte]] / width; }
+        bool accepts_row(int row) const { return (accept_bits[row >> 6] >> (row & 63)) & 1; }
+        //bytes with the same column are interchangeable
+        uint32_t byte_column(unsigned char byte) const { return column[byte]; }
+        //columns are the symbol classes of the dfa compiled, plus the sink
+        //column. step by column rather than byte
+        int column_count() const { return width; }
+        int next_row_in_column(int row, int c) const { return table[row * width + c] / width; }
+
+        //write the table, plus dictionary (may be empty), as a binary file
+        void save(const string &file_name, const string &dictionary) const;
+        //the dictionary of a mapped file, empty if it has none
+        string_view dictionary() const { return names; }
+        //write the .dfa text output the dfa this was compiled from would
+        //have written, using the names in the dictionary
+        void print_to_file(const string &file_name) const;
+        //write a self-contained c++17 header, file_name.hpp, defining 
+        //name::matches(begin, end) for this dfa. past goto_row_limit rows 
+        //the goto style falls back to the table style
+        void print_header(const string &file_name, const string &name, HeaderStyle style) const;
+        //compilers take superlinear time over one function of labels: at 
+        //-O2, g++ takes seconds at 1024 rows, over a minute at 2048 and 
+        //doesn't finish at 16k
+        static const uint32_t goto_row_limit = 1024;
+        bool goto_fits() const { return rows <= goto_row_limit; }
+
+    private:
+        //layout of a binary file. all offsets are from the start of the file
+        static constexpr char file_magic[8] = {'N', 'F', 'A', 'D', 'F', 'A', 'B', '\0'};
+        static const uint32_t file_version = 1;
+        struct file_header {
+            char magic[8];
+            uint32_t version;
+            uint32_t rows;
+            uint32_t width;
+            uint32_t start;
+            uint64_t column_offset;     //uint32_t[256]
+            uint64_t table_offset;      //uint32_t[rows * width]
+            uint64_t accept_offset;     //uint64_t[(rows + 63) / 64]
+            uint64_t dictionary_offset; //0 when there is no dictionary
+            uint64_t dictionary_size;
+            uint64_t file_size;
+        };
+
+        bool accepts(uint32_t state) const {
+            uint32_t row = state / width;
+            return (accept_bits[row >> 6] >> (row & 63)) & 1;
+        }
+
+        CompiledDFA() {}
+        //map and check a binary file. returns why it isn't a valid compiled
+        //dfa, or null if it is
+        const char* map_binary(const string &binary_file, bool check_table);
+
+        void write_table_matcher(BufferedWriter &out) const;
+        void write_goto_matcher(BufferedWriter &out) const;
+
+        //take steps steps in every lane. avx2 builds gather 8 lanes at a time
+        void advance_lanes(uint32_t* state, const unsigned char** pos, size_t steps) const;
+
+        uint32_t rows;
+        uint32_t width; //columns per row
+        uint32_t start;
+        const uint32_t* column;
+        const uint32_t* table;
+        const uint64_t* accept_bits;
+        string_view names;
+
+        //backing storage: owned arrays when compiled in memory, or the mapping
+        vector<uint32_t> owned_column, owned_table;
+        vector<uint64_t> owned_accepts;
+        unique_ptr<MappedFile> mapped;
+};
+
+CompiledDFA::CompiledDFA(const DFA &dfa) {
+    int n = dfa.states.size();
+    rows = n + 1;
+    width = dfa.class_count + 1;
+    owned_column.resize(256);
+    for (int i = 0; i < 256; i++) {
+        owned_column[i] = dfa.byte_class[i] == -1 ? dfa.class_count : dfa.byte_class[i];
+    }
+
+    uint32_t sink = n * width;
+    owned_table.assign(rows * width, sink);
+    owned_accepts.assign((rows + 63) / 64, 0);
+
+    //states are numbered by their position in dfa.states
+    vector<uint32_t> row_of(dfa.transitions.size(), 0);
+    for (int i = 0; i < n; i++) row_of[dfa.states[i]] = i * width;
+
+    for (int i = 0; i < n; i++) {
+        const int* row = dfa.transitions[dfa.states[i]];
+        for (int c = 0; c < dfa.class_count; c++) owned_table[i * width + c] = row_of[row[c]];
+    }
+    for (int accept : dfa.accept_states) {
+        uint32_t row = row_of[accept] / width;
+        owned_accepts[row >> 6] |= uint64_t(1) << (row & 63);
+    }
+    start = row_of[dfa.start_state];
+
+    column = owned_column.data();
+    table = owned_table.data();
+    accept_bits = owned_accepts.data();
+}
+
+CompiledDFA::CompiledDFA(const string &binary_file, bool check_table) {
+    if (const char* error = map_binary(binary_file, check_table)) {
+        cerr << binary_file << ": " << error << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+unique_ptr<CompiledDFA> CompiledDFA::load(const string &binary_file, string &error, 
+                                          bool check_table) {
+    if (access(binary_file.c_str(), R_OK) != 0) {
+        error = "can't open";
+        return nullptr;
+    }
+    unique_ptr<CompiledDFA> compiled(new CompiledDFA());
+    if (const char* reason = compiled->map_binary(binary_file, check_table)) {
+        error = reason;
+        return nullptr;
+    }
+    return compiled;
+}
+
+const char* CompiledDFA::map_binary(const string &binary_file, bool check_table) {
+    mapped.reset(new MappedFile(binary_file, MADV_RANDOM));
+    const char* data = mapped->data();
+    size_t size = mapped->size();
+
+    if (size < sizeof(file_header)) return "too short to be a compiled dfa";
+
+    const file_header* header = (const file_header*) data;
+    if (memcmp(header->magic, file_magic, sizeof(file_magic)) != 0) return "not a compiled dfa";
+    if (header->version != file_version) return "unsupported compiled dfa version";
+    if (header->file_size != size) return "truncated";
+    if (header->rows == 0 || header->width == 0) return "empty table";
+
+    //rows * width can't overflow, but times four can. sections are checked
+    //as offset <= size - length so neither side can wrap
+    if (uint64_t(header->rows) * header->width > size / sizeof(uint32_t)) return "table out of bounds";
+    uint64_t table_bytes = uint64_t(header->rows) * header->width * sizeof(uint32_t);
+    uint64_t accept_bytes = (header->rows + 63) / 64 * sizeof(uint64_t);
+    auto in_bounds = [&](uint64_t offset, uint64_t length, uint64_t alignment) {
+        return length <= size && offset <= size - length && offset % alignment == 0;
+    };
+    if (!in_bounds(header->column_offset, 256 * sizeof(uint32_t), sizeof(uint32_t))
+        || !in_bounds(header->table_offset, table_bytes, sizeof(uint32_t))
+        || !in_bounds(header->accept_offset, accept_bytes, sizeof(uint64_t))
+        || !in_bounds(header->dictionary_offset, header->dictionary_size, 1)) {
+        return "section out of bounds or misaligned";
+    }
+
+    rows = header->rows;
+    width = header->width;
+    start = header->start;
+    column = (const uint32_t*) (data + header->column_offset);
+    table = (const uint32_t*) (data + header->table_offset);
+    accept_bits = (const uint64_t*) (data + header->accept_offset);
+    if (header->dictionary_offset != 0) {
+        names = string_view(data + header->dictionary_offset, header->dictionary_size);
+    }
+
+    //a table entry past the end would make matching read out of bounds
+    if (start % width != 0 || start / width >= rows) return "bad start state";
+    for (int i = 0; i < 256; i++) {
+        if (column[i] >= width) return "bad column map";
+    }
+    if (!check_table) return nullptr;
+    for (uint64_t i = 0; i < uint64_t(rows) * width; i++) {
+        if (table[i] % width != 0 || table[i] / width >= rows) return "bad transition";
+    }
+    return nullptr;
+}
+
+void CompiledDFA::save(const string &file_name, const string &dictionary) const {
+    auto aligned = [](uint64_t offset) { return (offset + 7) & ~uint64_t(7); };
+
+    file_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, file_magic, sizeof(file_magic));
+    header.version = file_version;
+    header.rows = rows;
+    header.width = width;
+    header.start = start;
+    header.column_offset = aligned(sizeof(header));
+    header.table_offset = aligned(header.column_offset + 256 * sizeof(uint32_t));
+    header.accept_offset = aligned(header.table_offset + uint64_t(rows) * width * sizeof(uint32_t));
+    uint64_t end = header.accept_offset + (rows + 63) / 64 * sizeof(uint64_t);
+    if (!dictionary.empty()) {
+        header.dictionary_offset = aligned(end);
+        header.dictionary_size = dictionary.size();
+        end = header.dictionary_offset + dictionary.size();
+    }
+    header.file_size = end;
+
+    string image(end, '\0');
+    memcpy(&image[0], &header, sizeof(header));
+    memcpy(&image[header.column_offset], column, 256 * sizeof(uint32_t));
+    memcpy(&image[header.table_offset], table, uint64_t(rows) * width * sizeof(uint32_t));
+    memcpy(&image[header.accept_offset], accept_bits, (rows + 63) / 64 * sizeof(uint64_t));
+    if (!dictionary.empty()) memcpy(&image[header.dictionary_offset], dictionary.data(), dictionary.size());
+
+    //a short write would leave a truncated file that looks like a whole one
+    //until it is loaded, and the cache renames what this writes into place
+    ofstream outfile(file_name, ios::binary);
+    outfile.write(image.data(), image.size());
+    outfile.close();
+    if (!outfile) {
+        cerr << "can't write " << file_name << endl;
+        unlink(file_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+}
+
+//the dictionary is plain length prefixed text: the symbol count, then each
+//symbol's class and name, then the state count, then each state's name in
+//compiled row order. nothing reads it on the matching path
+void DFA::print_binary(string file_name) const {
+    string dictionary;
+    auto put_u32 = [&](uint32_t value) { dictionary.append((const char*) &value, sizeof(value)); };
+    auto put_string = [&](const string &text) { put_u32(text.size()); dictionary += text; };
+
+    put_u32(alphabet.size());
+    for (int a = 0; a < (int) alphabet.size(); a++) {
+        put_u32(symbol_class[a]);
+        put_string(alphabet[a]);
+    }
+    put_u32(states.size());
+    for (int state : states) put_string(string_subset(state));
+
+    CompiledDFA(*this).save(file_name + ".dfab", dictionary);
+}
+
+void DFA::print_header(string file_name, const string &name, HeaderStyle style) const {
+    CompiledDFA(*this).print_header(file_name, name, style);
+}
+
+void CompiledDFA::print_to_file(const string &file_name) const {
+    const char* pos = names.data();
+    const char* end = pos + names.size();
+    auto corrupt = [&]() {
+        cerr << file_name << ": compiled dfa has no usable dictionary" << endl;
+        exit(EXIT_FAILURE);
+    };
+    auto get_u32 = [&]() {
+        uint32_t value;
+        if (end - pos < (ptrdiff_t) sizeof(value)) corrupt();
+        memcpy(&value, pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    };
+    auto get_string = [&]() {
+        uint32_t length = get_u32();
+        if ((uint64_t) (end - pos) < length) corrupt();
+        pos += length;
+        return string_view(pos - length, length);
+    };
+
+    uint32_t symbol_count = get_u32();
+    vector<uint32_t> symbol_column(symbol_count);
+    vector<string_view> symbols(symbol_count);
+    for (uint32_t a = 0; a < symbol_count; a++) {
+        symbol_column[a] = get_u32();
+        symbols[a] = get_string();
+        if (symbol_column[a] >= width) corrupt();
+    }
+    uint32_t state_total = get_u32();
+    if (state_total + 1 != rows) corrupt();
+    vector<string_view> state_names(state_total);
+    for (uint32_t i = 0; i < state_total; i++) state_names[i] = get_string();
+
+    //rows past the named states are the sink, which the text never shows
+    BufferedWriter out(file_name + ".dfa");
+    for (string_view name : state_names) {
+        out.write(name);
+        out.put(' ');
+    }
+    out.put('\n');
+    for (string_view symbol : symbols) {
+        out.write(symbol);
+        out.put('\t');
+    }
+    out.put('\n');
+    out.write(state_names[start / width]);
+    out.put('\n');
+    for (uint32_t row = 0; row < state_total; row++) {
+        if (accepts(row * width)) {
+            out.write(state_names[row]);
+            out.put(' ');
+        }
+    }
+    out.put('\n');
+    for (uint32_t row = 0; row < state_total; row++) {
+        for (uint32_t a = 0; a < symbol_count; a++) {
+            out.write(state_names[row]);
+            out.write(", ");
+            out.write(symbols[a]);
+            out.write(" = ");
+            out.write(state_names[table[row * width + symbol_column[a]] / width]);
+            out.write(" \n");
+        }
+    }
+}
+
+//code generation ------------------------------------------------
+//states in generated code are row numbers, and the sink is an ordinary 
+//state, so both styles accept exactly what matches does
+void CompiledDFA::print_header(const string &file_name, const string &name, HeaderStyle style) const {
+    auto word_char = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    };
+    bool identifier = !name.empty() && !(name[0] >= '0' && name[0] <= '9');
+    for (char c : name) identifier &= word_char(c);
+    if (!identifier) {
+        cerr << name << " is not a c++ identifier" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (style == HeaderStyle::goto_switch && !goto_fits()) {
+        cerr << rows << " states is too many for a goto matcher, writing a table matcher" << endl;
+        style = HeaderStyle::table;
+    }
+
+    BufferedWriter out(file_name + ".hpp");
+    out.write("//generated by nfa_dfa_converter: " + to_string(rows) + " states, " 
+              + to_string(width) + " columns\n");
+    out.write("#pragma once\n#include <cstdint>\n\nnamespace " + name + " {\n\n");
+    if (style == HeaderStyle::table) write_table_matcher(out);
+    else write_goto_matcher(out);
+    out.write("\n} //namespace " + name + "\n");
+}
+
+//the smallest unsigned type that holds values 0..count-1
+static const char* index_type(uint64_t count) {
+    if (count <= 256) return "uint8_t";
+    if (count <= 65536) return "uint16_t";
+    return "uint32_t";
+}
+
+//the table is laid out as in CompiledDFA, a state being its row offset, so
+//a step is one add and one load. the state type is sized to the table
+void CompiledDFA::write_table_matcher(BufferedWriter &out) const {
+    string state_type = index_type(uint64_t(rows) * width);
+    string column_type = index_type(width);
+
+    out.write("inline constexpr uint32_t width = " + to_string(width) + ";\n");
+    out.write("inline constexpr " + state_type + " start = " + to_string(start) + ";\n\n");
+    out.write("inline constexpr " + column_type + " column[256] = {");
+    for (int byte = 0; byte < 256; byte++) {
+        out.write(byte % 16 ? " " : "\n    ");
+        out.write(to_string(column[byte]) + ",");
+    }
+    out.write("\n};\n\n");
+
+    out.write("inline constexpr " + state_type + " table[" + to_string(rows) + " * width] = {\n");
+    for (uint32_t row = 0; row < rows; row++) {
+        out.write("   ");
+        for (uint32_t c = 0; c < width; c++) out.write(" " + to_string(table[row * width + c]) + ",");
+        out.write("\n");
+    }
+    out.write("};\n\n");
+
+    out.write("inline constexpr uint64_t accepting[" + to_string((rows + 63) / 64) + "] = {\n");
+    for (uint32_t i = 0; i < (rows + 63) / 64; i++) {
+        out.write("    " + to_string(accept_bits[i]) + "ull,\n");
+    }
+    out.write("};\n\n");
+
+    out.write("constexpr bool matches(const char* begin, const char* end) {\n"
+              "    " + state_type + " state = start;\n"
+              "    for (; begin != end; ++begin) state = table[state + column[(unsigned char) *begin]];\n"
+              "    uint32_t row = state / width;\n"
+              "    return (accepting[row >> 6] >> (row & 63)) & 1;\n"
+              "}\n");
+}
+
+//a row that can't reach an accepting row never will accept, so jumps to
+//it become return false. only rows reachable from the start get
+//a label. within a row the most common target is the default case
+void CompiledDFA::write_goto_matcher(BufferedWriter &out) const {
+    auto target = [&](uint32_t row, int byte) { return table[row * width + column[byte]] / width; };
+    //live rows can reach an accepting row: walk the transitions backwards
+    vector<vector<uint32_t>> sources(rows);
+    for (uint32_t row = 0; row < rows; row++) {
+        for (uint32_t c = 0; c < width; c++) sources[table[row * width + c] / width].push_back(row);
+    }
+    vector<bool> dead(rows, true);
+    vector<uint32_t> live;
+    for (uint32_t row = 0; row < rows; row++) {
+        if (accepts_row(row)) {
+            dead[row] = false;
+            live.push_back(row);
+        }
+    }
+    for (size_t i = 0; i < live.size(); i++) {
+        for (uint32_t source : sources[live[i]]) {
+            if (dead[source]) {
+                dead[source] = false;
+                live.push_back(source);
+            }
+        }
+    }
+
+    uint32_t first = start / width;
+    if (dead[first]) {
+        out.write("constexpr bool matches(const char*, const char*) { return false; }\n");
+        return;
+    }
+
+    vector<uint32_t> order = {first};
+    vector<bool> reached(rows, false);
+    reached[first] = true;
+    for (size_t i = 0; i < order.size(); i++) {
+        for (int byte = 0; byte < 256; byte++) {
+            uint32_t next = target(order[i], byte);
+            if (!dead[next] && !reached[next]) {
+                reached[next] = true;
+                order.push_back(next);
+            }
+        }
+    }
+
+    auto jump = [&](uint32_t row) { 
+        return dead[row] ? string("return false;") : "goto s" + to_string(row) + ";"; 
+    };
+    out.write("inline bool matches(const char* begin, const char* end) {\n"
+              "    const unsigned char* p = (const unsigned char*) begin;\n"
+              "    const unsigned char* stop = (const unsigned char*) end;\n"
+              "    " + jump(first) + "\n");
+
+    //every dead row is the one jump, so they are counted together as row
+    //number rows
+    auto jump_target = [&](uint32_t row, int byte) { 
+        uint32_t next = target(row, byte);
+        return dead[next] ? rows : next;
+    };
+    dead.push_back(true);
+    vector<int> count(rows + 1, 0);
+    for (uint32_t row : order) {
+        //the bytes going to each target, in byte order
+        vector<uint32_t> targets;
+        for (int byte = 0; byte < 256; byte++) {
+            uint32_t next = jump_target(row, byte);
+            if (count[next]++ == 0) targets.push_back(next);
+        }
+        uint32_t fallback = targets[0];
+        for (uint32_t next : targets) {
+            if (count[next] > count[fallback]) fallback = next;
+        }
+
+        out.write("  s" + to_string(row) + ":\n");
+        out.write(string("    if (p == stop) return ") + (accepts_row(row) ? "true" : "false") + ";\n");
+        out.write("    switch (*p++) {\n");
+        for (uint32_t next : targets) {
+            if (next == fallback) continue;
+            out.write("       ");
+            for (int byte = 0; byte < 256; byte++) {
+                if (jump_target(row, byte) == next) out.write(" case " + to_string(byte) + ":");
+            }
+            out.write(" " + jump(next) + "\n");
+        }
+        out.write("        default: " + jump(fallback) + "\n    }\n");
+        for (uint32_t next : targets) count[next] = 0;
+    }
+    out.write("}\n");
+}
+
+#ifdef __AVX2__
+void CompiledDFA::advance_lanes(uint32_t* state, const unsigned char** pos, 
+                                size_t steps) const {
+    const int* t = (const int*) table;
+    __m256i low = _mm256_loadu_si256((const __m256i*) state);
+    __m256i high = _mm256_loadu_si256((const __m256i*) (state + 8));
+    for (size_t s = 0; s < steps; s++) {
+        __m256i low_bytes = _mm256_setr_epi32(
+            column[pos[0][s]], column[pos[1][s]], column[pos[2][s]], column[pos[3][s]],
+            column[pos[4][s]], column[pos[5][s]], column[pos[6][s]], column[pos[7][s]]);
+        __m256i high_bytes = _mm256_setr_epi32(
+            column[pos[8][s]], column[pos[9][s]], column[pos[10][s]], column[pos[11][s]],
+            column[pos[12][s]], column[pos[13][s]], column[pos[14][s]], column[pos[15][s]]);
+        low = _mm256_i32gather_epi32(t, _mm256_add_epi32(low, low_bytes), 4);
+        high = _mm256_i32gather_epi32(t, _mm256_add_epi32(high, high_bytes), 4);
+    }
+    _mm256_storeu_si256((__m256i*) state, low);
+    _mm256_storeu_si256((__m256i*) (state + 8), high);
+    for (int l = 0; l < batch_lanes; l++) pos[l] += steps;
+}
+#else
+void CompiledDFA::advance_lanes(uint32_t* state, const unsigned char** pos, 
+                                size_t steps) const {
+    const uint32_t* t = table;
+    for (size_t s = 0; s < steps; s++) {
+        for (int l = 0; l < batch_lanes; l++) state[l] = t[state[l] + column[pos[l][s]]];
+    }
+    for (int l = 0; l < batch_lanes; l++) pos[l] += steps;
+}
+#endif
+
+//every lane holds one input. all lanes advance by the length of the shortest
+//input left, then finished lanes record their result and pick up the next
+//input. once there are no inputs left to hand out, the lanes still running
+//are finished one at a time
+void CompiledDFA::match_batch(const string_view* inputs, size_t count, 
+                              uint8_t* results) const {
+    uint32_t state[batch_lanes];
+    const unsigned char* pos[batch_lanes];
+    size_t remaining[batch_lanes], index[batch_lanes];
+    bool live[batch_lanes];
+    size_t next = 0;
+
+    //load the next nonempty input into lane l, settling empty ones on the way
+    auto refill = [&](int l) {
+        while (next < count && inputs[next].empty()) results[next++] = accepts(start);
+        live[l] = next < count;
+        if (!live[l]) return false;
+        pos[l] = (const unsigned char*) inputs[next].data();
+        remaining[l] = inputs[next].size();
+        state[l] = start;
+        index[l] = next++;
+        return true;
+    };
+
+    bool full = true;
+    for (int l = 0; l < batch_lanes; l++) full = refill(l) && full;
+
+    while (full) {
+        size_t steps = remaining[0];
+        for (int l = 1; l < batch_lanes; l++) steps = min(steps, remaining[l]);
+        advance_lanes(state, pos, steps);
+
+        for (int l = 0; l < batch_lanes; l++) {
+            remaining[l] -= steps;
+            if (remaining[l] > 0) continue;
+            results[index[l]] = accepts(state[l]);
+            full = refill(l) && full;
+        }
+    }
+
+    for (int l = 0; l < batch_lanes; l++) {
+        if (!live[l]) continue;
+        const uint32_t* t = table;
+        for (size_t s = 0; s < remaining[l]; s++) state[l] = t[state[l] + column[pos[l][s]]];
+        results[index[l]] = accepts(state[l]);
+    }
+}
+
+//stream a file through a compiled dfa, or any other matcher with a
+//matches(begin, end), one line at a time, printing accept or reject for 
+//each line. the scan itself is timed on its own, results are only printed
+//once it is done
+template<class Matcher>
+void match_file(const Matcher &compiled, const string &input_file) {
+    MappedFile input(input_file);
+
+    vector<uint8_t> results;
+    auto begin = chrono::steady_clock::now();
+    const char* line = input.data();
+    const char* end = input.data() + input.size();
+    while (line < end) {
+        const char* newline = (const char*) memchr(line, '\n', end - line);
+        if (newline == nullptr) newline = end;
+        results.push_back(compiled.matches(line, newline));
+        line = newline + 1;
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+
+    size_t accepted = 0;
+    string output;
+    for (uint8_t result : results) {
+        output += result ? "accept\n" : "reject\n";
+        accepted += result;
+    }
+    cout << output;
+
+    cerr << "lines: " << results.size() << " (" << accepted << " accepted)" << endl;
+    cerr << "bytes: " << input.size() << endl;
+    cerr << "seconds: " << elapsed.count() << endl;
+    cerr << "throughput: " << input.size() / elapsed.count() / 1e9 << " GB/s" << endl;
+}
+
+//the lines of a file, without their newlines, for the benchmarks that
+//match a line at a time
+vector<string_view> split_lines(const MappedFile &input) {
+    vector<string_view> lines;
+    const char* line = input.data();
+    const char* end = input.data() + input.size();
+    while (line < end) {
+        const char* newline = (const char*) memchr(line, '\n', end - line);
+        if (newline == nullptr) newline = end;
+        lines.push_back(string_view(line, newline - line));
+        line = newline + 1;
+    }
+    return lines;
+}
+
+//a fresh directory under /tmp for the scratch files of a benchmark or
+//check, named prefix_XXXXXX. it goes, with everything in it, when this goes
+//out of scope, or on remove before exiting on a failure
+class ScratchDirectory {
+    public:
+        ScratchDirectory(const string &prefix);
+        ~ScratchDirectory() { remove(); }
+        ScratchDirectory(const ScratchDirectory&) = delete;
+        ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+
+        //path of a file in the directory
+        string file(const string &name) const { return path + "/" + name; }
+        const string& directory() const { return path; }
+        void remove();
+
+    private:
+        string path; //empty once removed
+};
+
+ScratchDirectory::ScratchDirectory(const string &prefix) {
+    path = "/tmp/" + prefix + "_XXXXXX";
+    if (mkdtemp(&path[0]) == nullptr) {
+        cerr << "can't create a scratch directory in /tmp" << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+void ScratchDirectory::remove() {
+    if (path.empty()) return;
+    if (DIR* listing = opendir(path.c_str())) {
+        while (struct dirent* entry = readdir(listing)) {
+            string name = entry->d_name;
+            if (name != "." && name != "..") unlink(file(name).c_str());
+        }
+        closedir(listing);
+    }
+    rmdir(path.c_str());
+    path.clear();
+}
+
+//lazy dfa class -------------------------------------------
+//matches strings against an nfa by determinizing on demand. a dfa state is
+//only built the first time some input reaches it, and each transition is 
+//only computed the first time it is taken. everything built lives in a 
+//cache with a fixed memory budget; when the budget runs out the cache is
+//flushed and matching carries on from the current state. the budget counts
+//what is really held: the subset table's arena and index arrays, and the
+//transition and accepting arrays at their capacity
+class LazyDFA {
+    public:
+        struct cache_stats {
+            size_t lookups = 0;      //transitions taken
+            size_t hits = 0;         //transitions already in the cache
+            size_t flushes = 0;
+            size_t states_built = 0; //across every flush
+        };
+
+        LazyDFA(const NFA &nfa, size_t cache_bytes = 1 << 20);
+
+        //does the nfa accept the string in [begin, end)
+        bool matches(const char* begin, const char* end);
+        const cache_stats& stats() const { return counters; }
+
+    private:
+        static constexpr int unknown = -1;
+
+        const NFA &nfa;
+        size_t budget;
+        size_t bytes_used;
+        StateSet nfa_accept_states;
+
+        SubsetTable cache;
+        vector<int> table;     //[state * class_count + symbol class] -> state, or unknown
+        vector<bool> accepting;
+        int start_state;
+        StateSet scratch;
+        cache_stats counters;
+
+        int add_state(const StateSet &subset);
+        int step(int state, int symbol_class);
+        void flush();
+};
+
+LazyDFA::LazyDFA(const NFA &nfa, size_t cache_bytes) : nfa(nfa), budget(cache_bytes) {
+    nfa_accept_states = StateSet(nfa.universe);
+    for (int state : nfa.accept_states) nfa_accept_states.insert(state);
+    scratch = StateSet(nfa.universe);
+    flush();
+    counters.flushes = 0; //the initial empty cache isn't a flush
+}
+
+//intern a subset, giving it an empty row of transitions if it is new
+int LazyDFA::add_state(const StateSet &subset) {
+    bool inserted;
+    int id = cache.intern(subset, inserted);
+    if (!inserted) return id;
+
+    table.resize(table.size() + nfa.class_count(), unknown);
+    accepting.push_back(subset.intersects(nfa_accept_states));
+    bytes_used = cache.bytes() + table.capacity() * sizeof(int) + accepting.capacity() / 8;
+    counters.states_built++;
+    return id;
+}
+
+void LazyDFA::flush() {
+    cache.clear();
+    vector<int>().swap(table);
+    vector<bool>().swap(accepting);
+    bytes_used = 0;
+    counters.flushes++;
+    StateSet start(nfa.universe);
+    nfa.add_epsilon_closure(nfa.start_state, start);
+    start_state = add_state(start);
+}
+
+//follow one transition, determinizing it first if it isn't cached yet
+int LazyDFA::step(int state, int symbol_class) {
+    counters.lookups++;
+    int &cached = table[state * nfa.class_count() + symbol_class];
+    if (cached != unknown) {
+        counters.hits++;
+        return cached;
+    }
+
+    scratch.clear();
+    cache.subset(state).for_each([&](int member) {
+        int symbol = nfa.class_symbol[symbol_class];
+        for (int target : nfa.targets(member, symbol)) nfa.add_epsilon_closure(target, scratch);
+    });
+
+    //out of room, counting the transition array doubling if it is full.
+    //start over with just the start state and where we're going
+    size_t growth = table.size() + nfa.class_count() > table.capacity() 
+                  ? table.capacity() * sizeof(int) : 0;
+    if (bytes_used + growth > budget) {
+        flush();
+        int next = add_state(scratch);
+        return next;
+    }
+
+    int next = add_state(scratch);
+    table[state * nfa.class_count() + symbol_class] = next; //table may have moved
+    return next;
+}
+
+bool LazyDFA::matches(const char* begin, const char* end) {
+    int state = start_state;
+    for (const char* c = begin; c != end; c++) {
+        int symbol_class = nfa.byte_class[(unsigned char) *c];
+        if (symbol_class == -1) return false;
+        state = step(state, symbol_class);
+    }
+    return accepting[state];
+}
+
+//match every line of a file with a lazy dfa, printing accept or reject for
+//each, then the cache statistics
+void lazy_match_file(const NFA &nfa, const string &input_file, size_t cache_bytes) {
+    ifstream input{ input_file };
+    if (!input) {
+        cerr << "can't open " << input_file << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    LazyDFA lazy(nfa, cache_bytes);
+    string line;
+    while (getline(input, line)) {
+        bool accepted = lazy.matches(line.data(), line.data() + line.size());
+        cout << (accepted ? "accept" : "reject") << '\n';
+    }
+
+    const LazyDFA::cache_stats &stats = lazy.stats();
+    cerr << "lookups: " << stats.lookups << endl;
+    cerr << "hit rate: " << (stats.lookups ? double(stats.hits) / stats.lookups : 0) << endl;
+    cerr << "flushes: " << stats.flushes << endl;
+    cerr << "states built: " << stats.states_built << endl;
+}
+
+//nfa simulation -------------------------------------------
+//matches strings against an nfa directly, keeping the set of active nfa
+//states as a bitset, so matching is linear in the input for any nfa and
+//nothing is determinized. this is the fallback when a conversion stops at
+//a limit. there are three kernels, chosen by nfa size:
+//
+//shift_and, for 64 states or fewer. the active set is one word. edges from
+//state i to i+1, which are most of the edges of a position automaton, are
+//taken for every active state at once as (active << 1) & shift_mask[class].
+//the states with any other edge on the class add theirs one at a time, and
+//states with epsilon edges then add their closure words.
+//
+//masks, while the successor sets fit in mask_budget bytes. for every state
+//and class the targets' epsilon closures are merged ahead of time into one
+//bitset, so a step ors one precomputed mask per active state.
+//
+//direct, for anything bigger. a step adds the epsilon closures of the
+//targets of every active state as it goes
+class NFASimulator {
+    public:
+        enum class Kernel { automatic, shift_and, masks, direct };
+
+        //kernel picks one, if the nfa is small enough for it
+        NFASimulator(const NFA &nfa, Kernel kernel = Kernel::automatic);
+
+        //does the nfa accept the bytes in [begin, end)
+        bool matches(const char* begin, const char* end) const;
+        Kernel kernel() const { return chosen; }
+        static const char* kernel_name(Kernel kernel);
+
+    private:
+        static const size_t mask_budget = 64 << 20;
+
+        const NFA &nfa;
+        Kernel chosen;
+        int k; //symbol classes
+        StateSet start;
+        StateSet accepting;
+
+        //shift_and
+        uint64_t start_word;
+        uint64_t accept_word;
+        vector<uint64_t> shift_mask;    //[class] bit t set for an edge t - 1 -> t
+        vector<uint64_t> irregular;     //[class] states with some other edge
+        vector<uint64_t> other_targets; //[state * k + class] those other targets
+        uint64_t epsilon_states;        //states with a closure beyond themselves
+        uint64_t closure_word[64];
+
+        //masks. mask_of is -1 when the state has no targets on the class
+        vector<int> mask_of;            //[state * k + class] -> mask index
+        vector<uint64_t> mask_words;    //mask i is words [i * words, (i + 1) * words)
+
+        bool build_masks();
+        void build_shift_and();
+        bool matches_shift_and(const unsigned char* c, const unsigned char* end) const;
+        bool matches_masks(const unsigned char* c, const unsigned char* end) const;
+        bool matches_direct(const unsigned char* c, const unsigned char* end) const;
+};
+
+NFASimulator::NFASimulator(const NFA &nfa, Kernel kernel) 
+    : nfa(nfa), k(nfa.class_count()), start(nfa.universe), accepting(nfa.universe) {
+    nfa.add_epsilon_closure(nfa.start_state, start);
+    for (int state : nfa.accept_states) accepting.insert(state);
+
+    bool small = nfa.universe <= 64;
+    if ((kernel == Kernel::automatic || kernel == Kernel::shift_and) && small) {
+        chosen = Kernel::shift_and;
+        build_shift_and();
+    } else if (kernel != Kernel::direct && build_masks()) {
+        chosen = Kernel::masks;
+    } else {
+        chosen = Kernel::direct;
+    }
+}
+
+const char* NFASimulator::kernel_name(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::shift_and: return "shift_and";
+        case Kernel::masks: return "masks";
+        case Kernel::direct: return "direct";
+        default: return "automatic";
+    }
+}
+
+void NFASimulator::build_shift_and() {
+    auto bit = [](int state) { return uint64_t(1) << state; };
+    start_word = start.words()[0];
+    accept_word = accepting.words()[0];
+    shift_mask.assign(k, 0);
+    irregular.assign(k, 0);
+    other_targets.assign(nfa.universe * k, 0);
+    epsilon_states = 0;
+
+    for (int state = 0; state < nfa.universe; state++) {
+        for (int c = 0; c < k; c++) {
+            for (int target : nfa.targets(state, nfa.class_symbol[c])) {
+                if (target == state + 1) shift_mask[c] |= bit(target);
+                else {
+                    irregular[c] |= bit(state);
+                    other_targets[state * k + c] |= bit(target);
+                }
+            }
+        }
+        StateSet closure(nfa.universe);
+        nfa.add_epsilon_closure(state, closure);
+        closure_word[state] = closure.words()[0];
+        if (closure_word[state] != bit(state)) epsilon_states |= bit(state);
+    }
+}
+
+bool NFASimulator::build_masks() {
+    int words = start.word_count();
+    size_t nonempty = 0;
+    for (int state = 0; state < nfa.universe; state++) {
+        for (int c = 0; c < k; c++) nonempty += nfa.targets(state, nfa.class_symbol[c]).size() > 0;
+    }
+    if (nonempty * words * sizeof(uint64_t) > mask_budget) return false;
+
+    mask_of.assign(nfa.universe * k, -1);
+    mask_words.reserve(nonempty * words);
+    StateSet mask(nfa.universe);
+    for (int state = 0; state < nfa.universe; state++) {
+        for (int c = 0; c < k; c++) {
+            StateRange targets = nfa.targets(state, nfa.class_symbol[c]);
+            if (targets.size() == 0) continue;
+            mask.clear();
+            for (int target : targets) nfa.add_epsilon_closure(target, mask);
+            mask_of[state * k + c] = mask_words.size() / words;
+            mask_words.insert(mask_words.end(), mask.words(), mask.words() + words);
+        }
+    }
+    return true;
+}
+
+bool NFASimulator::matches(const char* begin, const char* end) const {
+    const unsigned char* c = (const unsigned char*) begin;
+    const unsigned char* stop = (const unsigned char*) end;
+    if (chosen == Kernel::shift_and) return matches_shift_and(c, stop);
+    if (chosen == Kernel::masks) return matches_masks(c, stop);
+    return matches_direct(c, stop);
+}
+
+bool NFASimulator::matches_shift_and(const unsigned char* c, const unsigned char* end) const {
+    uint64_t active = start_word;
+    for (; c != end; c++) {
+        int symbol_class = nfa.byte_class[*c];
+        if (symbol_class == -1) return false;
+
+        uint64_t next = (active << 1) & shift_mask[symbol_class];
+        for (uint64_t rest = active & irregular[symbol_class]; rest; rest &= rest - 1) {
+            next |= other_targets[__builtin_ctzll(rest) * k + symbol_class];
+        }
+        for (uint64_t rest = next & epsilon_states; rest; rest &= rest - 1) {
+            next |= closure_word[__builtin_ctzll(rest)];
+        }
+        active = next;
+        if (active == 0) return false;
+    }
+    return (active & accept_word) != 0;
+}
+
+bool NFASimulator::matches_masks(const unsigned char* c, const unsigned char* end) const {
+    int words = start.word_count();
+    StateSet current = start, next(nfa.universe);
+    for (; c != end; c++) {
+        int symbol_class = nfa.byte_class[*c];
+        if (symbol_class == -1) return false;
+
+        next.clear();
+        uint64_t* out = next.words();
+        bool any = false;
+        current.for_each([&](int state) {
+            int mask = mask_of[state * k + symbol_class];
+            if (mask == -1) return;
+            const uint64_t* in = &mask_words[(size_t) mask * words];
+            for (int i = 0; i < words; i++) out[i] |= in[i];
+            any = true;
+        });
+        if (!any) return false;
+        swap(current, next);
+    }
+    return current.intersects(accepting);
+}
+
+bool NFASimulator::matches_direct(const unsigned char* c, const unsigned char* end) const {
+    StateSet current = start, next(nfa.universe);
+    for (; c != end; c++) {
+        int symbol_class = nfa.byte_class[*c];
+        if (symbol_class == -1) return false;
+        int symbol = nfa.class_symbol[symbol_class];
+
+        next.clear();
+        current.for_each([&](int state) {
+            for (int target : nfa.targets(state, symbol)) nfa.add_epsilon_closure(target, next);
+        });
+        swap(current, next);
+        if (current.empty()) return false;
+    }
+    return current.intersects(accepting);
+}
+
+//equivalence checking ------------------------------------------
+//hopcroft and karp's near-linear check that two deterministic automata
+//accept the same language. pairs of states reached by the same string are
+//merged with union-find, and a pair whose states are already in one set 
+//follows from the pairs before it, so it is not explored. pairs go breadth
+//first, so the first pair that disagrees on accepting gives a shortest 
+//string accepted by exactly one side.
+//
+//each side is a view with start(), accepts(state) and next(state, symbol)
+//over dense state ids. symbols lists the symbols to step on
+struct equivalence_result {
+    bool equivalent;
+    int pairs;                  //pairs explored
+    vector<int> counterexample; //symbols, when not equivalent
+    bool left_accepts;          //which side accepts the counterexample
+};
+
+template<class Left, class Right>
+equivalence_result check_equivalence(Left &left, Right &right, const vector<int> &symbols) {
+    //union-find over the states of both sides, by size with path halving
+    vector<int> parent, set_size;
+    vector<int> left_node, right_node; //state -> node, or -1
+    auto node = [&](vector<int> &nodes, int state) {
+        if (state >= (int) nodes.size()) nodes.resize(state + 1, -1);
+        if (nodes[state] == -1) {
+            nodes[state] = parent.size();
+            parent.push_back(parent.size());
+            set_size.push_back(1);
+        }
+        return nodes[state];
+    };
+    auto find = [&](int x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    auto unite = [&](int a, int b) {
+        if (set_size[a] < set_size[b]) swap(a, b);
+        parent[b] = a;
+        set_size[a] += set_size[b];
+    };
+
+    //the pairs are the queue, each remembering the pair and symbol it came from
+    struct pair_entry { int left, right, from, symbol; };
+    vector<pair_entry> pairs;
+    pairs.push_back({left.start(), right.start(), -1, -1});
+    unite(node(left_node, left.start()), node(right_node, right.start()));
+
+    equivalence_result result{true, 0, {}, false};
+    for (size_t i = 0; i < pairs.size(); i++) {
+        pair_entry p = pairs[i];
+        if (left.accepts(p.left) != right.accepts(p.right)) {
+            result.equivalent = false;
+            result.left_accepts = left.accepts(p.left);
+            for (int at = i; pairs[at].from != -1; at = pairs[at].from) {
+                result.counterexample.push_back(pairs[at].symbol);
+            }
+            reverse(result.counterexample.begin(), result.counterexample.end());
+            break;
+        }
+        for (int symbol : symbols) {
+            int l = left.next(p.left, symbol), r = right.next(p.right, symbol);
+            int a = find(node(left_node, l)), b = find(node(right_node, r));
+            if (a == b) continue;
+            unite(a, b);
+            pairs.push_back({l, r, (int) i, symbol});
+        }
+    }
+    result.pairs = pairs.size();
+    return result;
+}
+
+//an nfa determinized on demand, as its own straightforward reference. it
+//shares nothing with DFA but the nfa's transitions and closures
+class SubsetView {
+    public:
+        SubsetView(const NFA &nfa);
+        int start() const { return 0; }
+        bool accepts(int state) const { return accepting[state]; }
+        int next(int state, int symbol);
+
+    private:
+        const NFA &nfa;
+        int k;
+        StateSet accept_states;
+        vector<StateSet> subsets;
+        vector<bool> accepting;
+        vector<int> successors; //[state * k + symbol], -1 until computed
+        unordered_map<string, int> ids; //subset words -> state
+
+        int intern(const StateSet &subset);
+};
+
+SubsetView::SubsetView(const NFA &nfa) 
+    : nfa(nfa), k(nfa.alphabet.size()), accept_states(nfa.universe) {
+    for (int state : nfa.accept_states) accept_states.insert(state);
+    StateSet start(nfa.universe);
+    nfa.add_epsilon_closure(nfa.start_state, start);
+    intern(start);
+}
+
+int SubsetView::intern(const StateSet &subset) {
+    string key((const char*) subset.words(), subset.word_count() * sizeof(uint64_t));
+    auto found = ids.emplace(key, subsets.size());
+    if (found.second) {
+        subsets.push_back(subset);
+        accepting.push_back(subset.intersects(accept_states));
+        successors.resize(successors.size() + k, -1);
+    }
+    return found.first->second;
+}
+
+int SubsetView::next(int state, int symbol) {
+    int &successor = successors[state * k + symbol];
+    if (successor == -1) {
+        StateSet target(nfa.universe);
+        subsets[state].for_each([&](int from) {
+            for (int to : nfa.targets(from, symbol)) nfa.add_epsilon_closure(to, target);
+        });
+        int id = intern(target);
+        successors[state * k + symbol] = id; //intern may have moved successors
+    }
+    return successors[state * k + symbol];
+}
+
+//a converted dfa, stepped by alphabet index like SubsetView
+class DFAView {
+    public:
+        DFAView(const DFA &dfa) : dfa(dfa), accepting(dfa.id_count(), false) {
+            for (int state : dfa.accepting()) accepting[state] = true;
+        }
+        int start() const { return dfa.start(); }
+        bool accepts(int state) const { return accepting[state]; }
+        int next(int state, int symbol) const { return dfa.next(state, symbol); }
+
+    private:
+        const DFA &dfa;
+        vector<bool> accepting;
+};
+
+//a compiled dfa, stepped by byte
+class CompiledView {
+    public:
+        CompiledView(const CompiledDFA &dfa) : dfa(dfa) {}
+        int start() const { return dfa.start_row(); }
+        bool accepts(int state) const { return dfa.accepts_row(state); }
+        int next(int state, int byte) const { return dfa.next_row(state, byte); }
+
+    private:
+        const CompiledDFA &dfa;
+};
+
+//a compiled dfa, stepped by alphabet index through the symbol classes of
+//the nfa it was converted from, as DFA::next does
+class ClassView {
+    public:
+        ClassView(const CompiledDFA &dfa, const NFA &nfa) : dfa(dfa), nfa(nfa) {}
+        int start() const { return dfa.start_row(); }
+        bool accepts(int state) const { return dfa.accepts_row(state); }
+        int next(int state, int symbol) const { 
+            return dfa.next_row_in_column(state, nfa.symbol_class[symbol]); 
+        }
+
+    private:
+        const CompiledDFA &dfa;
+        const NFA &nfa;
+};
+
+//print the result of a check. symbol names are run together when they are
+//all one character, and spaced otherwise
+bool report_equivalence(const equivalence_result &result, const vector<string> &symbol_names,
+                        const char* left, const char* right) {
+    if (result.equivalent) {
+        cerr << "equivalent (" << result.pairs << " pairs)" << endl;
+        return true;
+    }
+    bool spaced = false;
+    for (const string &name : symbol_names) spaced |= name.size() != 1;
+    string text;
+    for (size_t i = 0; i < result.counterexample.size(); i++) {
+        if (spaced && i > 0) text += ' ';
+        text += symbol_names[result.counterexample[i]];
+    }
+    cerr << "not equivalent: \"" << text << "\" is accepted by " 
+         << (result.left_accepts ? left : right) << " only" << endl;
+    return false;
+}
+
+//does a dfa accept the language of the nfa it was converted from
+bool verify_dfa(const NFA &nfa, const DFA &dfa, bool quiet = false) {
+    SubsetView reference(nfa);
+    DFAView converted(dfa);
+    vector<int> symbols(nfa.alphabet.size());
+    for (size_t a = 0; a < symbols.size(); a++) symbols[a] = a;
+    equivalence_result result = check_equivalence(reference, converted, symbols);
+    if (quiet && result.equivalent) return true;
+    return report_equivalence(result, nfa.alphabet, "the nfa", "the dfa");
+}
+
+//does a dfa answered from the cache accept the language of the nfa
+bool verify_cached(const NFA &nfa, const CompiledDFA &cached) {
+    if (cached.column_count() != nfa.class_count() + 1) {
+        cerr << "the cached dfa doesn't have the nfa's symbol classes" << endl;
+        return false;
+    }
+    SubsetView reference(nfa);
+    ClassView converted(cached, nfa);
+    vector<int> symbols(nfa.alphabet.size());
+    for (size_t a = 0; a < symbols.size(); a++) symbols[a] = a;
+    return report_equivalence(check_equivalence(reference, converted, symbols), nfa.alphabet, 
+                              "the nfa", "the cached dfa");
+}
+
+//do two compiled dfas accept the same strings of bytes. bytes that share
+//a column in both tables are stepped once
+bool verify_compiled(const CompiledDFA &left, const CompiledDFA &right) {
+    vector<int> symbols;
+    unordered_set<uint64_t> seen;
+    for (int byte = 0; byte < 256; byte++) {
+        if (seen.insert(uint64_t(left.byte_column(byte)) << 32 | right.byte_column(byte)).second) {
+            symbols.push_back(byte);
+        }
+    }
+    vector<string> byte_names(256);
+    for (int byte = 0; byte < 256; byte++) {
+        char escaped[5];
+        if (byte >= 0x20 && byte < 0x7f && byte != '"' && byte != '\\') byte_names[byte] = string(1, (char) byte);
+        else {
+            snprintf(escaped, sizeof(escaped), "\\x%02x", byte);
+            byte_names[byte] = escaped;
+        }
+    }
+    CompiledView a(left), b(right);
+    return report_equivalence(check_equivalence(a, b, symbols), byte_names, "the first", "the second");
+}
+
+//benchmark ------------------------------------------------------
+//time the conversion of nfa at 1/2/4/8/16 threads and report the speedup
+//over a single thread
+void bench_threads(const NFA &nfa, ExploreOrder order) {
+    const int thread_counts[] = {1, 2, 4, 8, 16};
+    double base_seconds = 0;
+
+    cout << "threads\tseconds\tspeedup\tstates" << endl;
+    for (int threads : thread_counts) {
+        auto begin = chrono::steady_clock::now();
+        DFA dfa(nfa, order, threads);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+
+        if (threads == 1) base_seconds = elapsed.count();
+        cout << threads << "\t" << elapsed.count() << "\t" 
+             << base_seconds / elapsed.count() << "\t" << dfa.state_count() << endl;
+    }
+}
+
+//match every line of input_file one at a time and then in batches, and
+//compare strings per second
+void bench_batch(const CompiledDFA &compiled, const string &input_file) {
+    MappedFile input(input_file);
+    vector<string_view> lines = split_lines(input);
+
+    vector<uint8_t> single(lines.size()), batched(lines.size());
+    auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < lines.size(); i++) {
+        single[i] = compiled.matches(lines[i].data(), lines[i].data() + lines[i].size());
+    }
+    chrono::duration<double> single_time = chrono::steady_clock::now() - begin;
+
+    begin = chrono::steady_clock::now();
+    compiled.match_batch(lines.data(), lines.size(), batched.data());
+    chrono::duration<double> batch_time = chrono::steady_clock::now() - begin;
+
+    if (single != batched) {
+        cerr << "batch results differ from single stream results!" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+#ifdef __AVX2__
+    const char* kernel = "avx2 gather";
+#else
+    const char* kernel = "scalar";
+#endif
+    cout << "strings: " << lines.size() << endl;
+    cout << "single stream: " << lines.size() / single_time.count() << " strings/s" << endl;
+    cout << "batch (" << CompiledDFA::batch_lanes << " lanes, " << kernel << "): " 
+         << lines.size() / batch_time.count() << " strings/s" << endl;
+    cout << "speedup: " << single_time.count() / batch_time.count() << endl;
+}
+
+//text in single quotes for /bin/sh, which takes everything inside them
+//literally except another single quote
+string shell_quote(const string &text) {
+    string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') quoted += "'\\''";
+        else quoted += c;
+    }
+    return quoted + "'";
+}
+
+//did a command run through system or popen exit with status 0
+static bool exited_cleanly(int status) {
+    return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//the generated matchers against the table interpreter, over the lines of
+//input_file. both headers go into a small driver compiled with $CXX (c++
+//if unset) at -O2, which times them the way this times matches. a hash of
+//which lines each engine accepts must agree. every engine gets an untimed
+//warm up pass, then the engines take turns for codegen_rounds rounds and
+//each reports its fastest, so none is timed cold or favoured by going 
+//first. a dfa too big for the goto style is timed with the table alone
+static const int codegen_rounds = 5;
+
+void bench_codegen(const CompiledDFA &compiled, const string &input_file) {
+    ScratchDirectory scratch("nfa_codegen");
+    bool with_goto = compiled.goto_fits();
+    compiled.print_header(scratch.file("table"), "table_matcher", HeaderStyle::table);
+    if (with_goto) compiled.print_header(scratch.file("goto"), "goto_matcher", HeaderStyle::goto_switch);
+
+    ofstream driver(scratch.file("driver.cpp"));
+    driver << R"(#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "table.hpp"
+)" << (with_goto ? "#include \"goto.hpp\"\n" : "") << R"(
+template<class Match> struct engine {
+    const char* name;
+    Match match;
+    double best = 1e300;
+    unsigned long long accepted = 0;
+
+    void run(const std::vector<std::string_view> &lines, bool timed) {
+        auto begin = std::chrono::steady_clock::now();
+        unsigned long long hash = 0;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (match(lines[i].data(), lines[i].data() + lines[i].size())) hash = hash * 31 + i + 1;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        accepted = hash;
+        if (timed && elapsed.count() < best) best = elapsed.count();
+    }
+    void report() const { std::printf("%s %.9f %llu\n", name, best, accepted); }
+};
+template<class Match> engine<Match> make_engine(const char* name, Match match) { return {name, match}; }
+
+int main(int, char** argv) {
+    std::ifstream input(argv[1], std::ios::binary);
+    std::stringstream contents;
+    contents << input.rdbuf();
+    std::string text = contents.str();
+    std::vector<std::string_view> lines;
+    for (size_t line = 0, newline; line < text.size(); line = newline + 1) {
+        newline = text.find('\n', line);
+        if (newline == std::string::npos) newline = text.size();
+        lines.push_back(std::string_view(text).substr(line, newline - line));
+    }
+    auto table = make_engine("table", [](const char* begin, const char* end) { return table_matcher::matches(begin, end); });
+)" << (with_goto ? R"(    auto go = make_engine("goto", [](const char* begin, const char* end) { return goto_matcher::matches(begin, end); });
+)" : "") << R"(    for (int round = 0; round <= )" << codegen_rounds << R"(; round++) {
+        table.run(lines, round > 0);
+)" << (with_goto ? "        go.run(lines, round > 0);\n" : "") << R"(    }
+    table.report();
+)" << (with_goto ? "    go.report();\n" : "") << R"(}
+)";
+    driver.close();
+
+    //$CXX is left unquoted so it can carry flags or a launcher, as in make
+    const char* cxx = getenv("CXX") ? getenv("CXX") : "c++";
+    string build = string(cxx) + " -std=c++17 -O2 -o " + shell_quote(scratch.file("driver")) + " " 
+                 + shell_quote(scratch.file("driver.cpp"));
+    auto begin = chrono::steady_clock::now();
+    if (!exited_cleanly(system(build.c_str()))) {
+        cerr << "can't compile the generated matchers: " << build << endl;
+        scratch.remove();
+        exit(EXIT_FAILURE);
+    }
+    chrono::duration<double> compile_time = chrono::steady_clock::now() - begin;
+
+    //the interpreter, over the same lines split the same way and timed the
+    //same way
+    MappedFile input(input_file);
+    vector<string_view> lines = split_lines(input);
+    unsigned long long expected = 0;
+    double interpreted = 1e300;
+    for (int round = 0; round <= codegen_rounds; round++) {
+        begin = chrono::steady_clock::now();
+        expected = 0;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (compiled.matches(lines[i].data(), lines[i].data() + lines[i].size())) expected = expected * 31 + i + 1;
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+        if (round > 0) interpreted = min(interpreted, elapsed.count());
+    }
+
+    cout << "compile seconds: " << compile_time.count() << endl;
+    cout << "engine\tseconds\tMB/s" << endl;
+    cout << "interpreter\t" << interpreted << "\t" << input.size() / interpreted / 1e6 << endl;
+
+    string run = shell_quote(scratch.file("driver")) + " " + shell_quote(input_file);
+    FILE* results = popen(run.c_str(), "r");
+    if (results == nullptr) {
+        cerr << "can't run the generated matchers: " << run << endl;
+        scratch.remove();
+        exit(EXIT_FAILURE);
+    }
+    char engine[16];
+    double seconds;
+    unsigned long long accepted;
+    int engines = 0;
+    bool differ = false;
+    while (fscanf(results, "%15s %lf %llu", engine, &seconds, &accepted) == 3) {
+        cout << engine << "\t" << seconds << "\t" << input.size() / seconds / 1e6 << endl;
+        if (accepted != expected) {
+            cerr << engine << " results differ!" << endl;
+            differ = true;
+        }
+        engines++;
+    }
+    if (!with_goto) cout << "goto\tskipped, over " << CompiledDFA::goto_row_limit << " states" << endl;
+    //a driver that fails partway must not pass for one that agreed
+    bool finished = exited_cleanly(pclose(results));
+    scratch.remove();
+    if (!finished || engines != (with_goto ? 2 : 1)) {
+        cerr << "the generated matchers failed: " << run << endl;
+        exit(EXIT_FAILURE);
+    }
+    if (differ) exit(EXIT_FAILURE);
+}
+
+//time loading an nfa file (parse, csr layout, closures) and report MB/s
+void bench_parse(const string &nfa_file) {
+    auto begin = chrono::steady_clock::now();
+    NFA nfa(nfa_file);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+
+    MappedFile file(nfa_file);
+    cout << "states: " << nfa.universe << endl;
+    cout << "transitions: " << nfa.edges.size() << endl;
+    cout << "bytes: " << file.size() << endl;
+    cout << "seconds: " << elapsed.count() << endl;
+    cout << "throughput: " << file.size() / elapsed.count() / 1e6 << " MB/s" << endl;
+}
+
+//time writing the .dfa text output of an nfa's dfa
+void bench_output(const NFA &nfa, ExploreOrder order) {
+    DFA dfa(nfa, order);
+    ScratchDirectory scratch("nfa_output");
+    auto begin = chrono::steady_clock::now();
+    dfa.print_to_file(scratch.file("converted_dfa"));
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+
+    MappedFile output(scratch.file("converted_dfa.dfa"));
+    cout << "states: " << dfa.state_count() << endl;
+    cout << "bytes: " << output.size() << endl;
+    cout << "seconds: " << elapsed.count() << endl;
+    cout << "throughput: " << output.size() / elapsed.count() / 1e6 << " MB/s" << endl;
+}
+
+//synthetic nfa families ------------------------------------
+//generators for the --bench-suite cases. each builds an nfa with states
+//0..states-1 and writes it out in the .nfa text format, so the suite times
+//the same parse the command line does
+struct generated_nfa {
+    int states;
+    vector<string> alphabet;
+    int start;
+    vector<int> accepts;
+    vector<NFA::edge> edges; //symbol is an alphabet index or NFA::epsilon
+
+    void write(const string &file_name) const;
+};
+
+void generated_nfa::write(const string &file_name) const {
+    BufferedWriter out(file_name);
+    auto state = [&](int id) { out.write("{" + to_string(id) + "}"); };
+
+    for (int id = 0; id < states; id++) {
+        state(id);
+        out.put('\t');
+    }
+    out.put('\n');
+    for (const string &symbol : alphabet) {
+        out.write(symbol);
+        out.put('\t');
+    }
+    out.put('\n');
+    state(start);
+    out.put('\n');
+    for (int id : accepts) {
+        state(id);
+        out.put('\t');
+    }
+    out.put('\n');
+    for (const NFA::edge &e : edges) {
+        state(e.from);
+        out.write(", ");
+        out.write(e.symbol == NFA::epsilon ? "EPS" : alphabet[e.symbol]);
+        out.write(" = ");
+        state(e.to);
+        out.put('\n');
+    }
+}
+
+//strings whose n-th symbol from the end is a. the smallest dfa has 2^n
+//states, the classic worst case for subset construction
+generated_nfa nth_from_end_nfa(int n) {
+    generated_nfa g{n + 1, {"a", "b"}, 0, {n}, {}};
+    g.edges.push_back({0, 0, 0});
+    g.edges.push_back({0, 1, 0});
+    g.edges.push_back({0, 0, 1});
+    for (int i = 1; i < n; i++) {
+        g.edges.push_back({i, 0, i + 1});
+        g.edges.push_back({i, 1, i + 1});
+    }
+    return g;
+}
+
+//each state has an edge on each of four symbols with probability 1/2, and
+//an epsilon edge with probability 1/20, to uniformly random states
+generated_nfa random_sparse_nfa(int n) {
+    generated_nfa g{n, {"a", "b", "c", "d"}, 0, {}, {}};
+    mt19937 random(n);
+    uniform_int_distribution<int> target(0, n - 1);
+    uniform_int_distribution<int> percent(0, 99);
+    for (int i = 0; i < n; i++) {
+        for (int a = 0; a < 4; a++) {
+            if (percent(random) < 50) g.edges.push_back({i, a, target(random)});
+        }
+        if (percent(random) < 5) g.edges.push_back({i, NFA::epsilon, target(random)});
+        if (percent(random) < 10) g.accepts.push_back(i);
+    }
+    return g;
+}
+
+//an epsilon edge from every state to the next, so closure i is {i..n-1}
+generated_nfa epsilon_chain_nfa(int n) {
+    generated_nfa g{n, {"a", "b"}, 0, {n - 1}, {}};
+    for (int i = 0; i < n - 1; i++) {
+        g.edges.push_back({i, NFA::epsilon, i + 1});
+        g.edges.push_back({i, 0, i});
+    }
+    g.edges.push_back({n - 1, 1, 0});
+    return g;
+}
+
+//32 states in a ring over n multi character symbols. symbol a moves a
+//steps round the ring, and s0 may also move one step, so every subset is
+//an arc of the ring
+generated_nfa large_alphabet_nfa(int n) {
+    generated_nfa g{32, {}, 0, {0, 31}, {}};
+    for (int a = 0; a < n; a++) g.alphabet.push_back("s" + to_string(a));
+    for (int i = 0; i < 32; i++) {
+        for (int a = 0; a < n; a++) g.edges.push_back({i, a, (i + a) % 32});
+        g.edges.push_back({i, 0, (i + 1) % 32});
+    }
+    return g;
+}
+
+//a chain of n a's, with b going back to the start
+generated_nfa long_path_nfa(int n) {
+    generated_nfa g{n + 1, {"a", "b"}, 0, {n}, {}};
+    for (int i = 0; i < n; i++) {
+        g.edges.push_back({i, 0, i + 1});
+        g.edges.push_back({i, 1, 0});
+    }
+    return g;
+}
+
+//up to ten states over up to three symbols, with a few epsilon edges. 
+//small enough that every corner of the converter shows up in a few
+//thousand seeds: empty languages, dead subsets, epsilon cycles
+generated_nfa random_small_nfa(int seed) {
+    mt19937 random(seed);
+    auto below = [&](int n) { return uniform_int_distribution<int>(0, n - 1)(random); };
+    generated_nfa g{1 + below(10), {}, 0, {}, {}};
+    int symbols = 1 + below(3);
+    for (int a = 0; a < symbols; a++) g.alphabet.push_back(string(1, 'a' + a));
+    g.start = below(g.states);
+    for (int i = 0; i < g.states; i++) {
+        for (int a = 0; a < symbols; a++) {
+            while (below(3) == 0) g.edges.push_back({i, a, below(g.states)});
+        }
+        if (below(6) == 0) g.edges.push_back({i, NFA::epsilon, below(g.states)});
+        if (below(3) == 0) g.accepts.push_back(i);
+    }
+    return g;
+}
+
+//a few random edits to g as a delta file for NFA::apply: transitions 
+//removed and added, possibly to a new state, an accept state toggled, 
+//and sometimes a state removed
+void write_random_delta(const generated_nfa &g, int seed, const string &file_name) {
+    mt19937 random(seed);
+    auto below = [&](int n) { return uniform_int_distribution<int>(0, n - 1)(random); };
+    BufferedWriter out(file_name);
+    auto edit = [&](char sign, const NFA::edge &e) {
+        out.write(string(1, sign) + " {" + to_string(e.from) + "}, ");
+        out.write(e.symbol == NFA::epsilon ? "EPS" : g.alphabet[e.symbol]);
+        out.write(" = {" + to_string(e.to) + "}\n");
+    };
+
+    for (int i = below(3); i > 0 && !g.edges.empty(); i--) edit('-', g.edges[below(g.edges.size())]);
+    int states = g.states + below(2); //maybe one new state
+    if (states > g.states) out.write("+state {" + to_string(g.states) + "}\n");
+    for (int i = 1 + below(3); i > 0; i--) {
+        int symbol = below(6) == 0 ? NFA::epsilon : below(g.alphabet.size());
+        edit('+', {below(states), symbol, below(states)});
+    }
+    if (below(2)) out.write((below(2) ? "+accept {" : "-accept {") + to_string(below(states)) + "}\n");
+    if (below(5) == 0) out.write("+state {" + to_string(g.states + 1) + "}\n");
+    if (below(5) == 0) {
+        int state = below(g.states);
+        if (state != g.start) out.write("-state {" + to_string(state) + "}\n");
+    }
+}
+
+//a random pattern over a, b and c in the syntax NFA::from_regex reads, 
+//with a matcher of its own for checking the front end against. matches 
+//walks the generated tree directly, sharing nothing with RegexParser or 
+//either nfa construction. every group and repeat is parenthesized, so the
+//pattern means what the tree does
+class random_regex {
+    public:
+        random_regex(int seed);
+        const string& pattern() const { return text; }
+        //every symbol the pattern uses, which is what . stands for
+        const string& symbols() const { return used; }
+        //does the whole of s match. s must be shorter than 32 bytes
+        bool matches(const string &s) const { return (ends(root, s, 0) >> s.size()) & 1; }
+
+    private:
+        struct node {
+            char kind;      //'l'iteral or class, '.', 'e'mpty, 'c'oncat, '|', '*', '+' or '?'
+            string symbols; //of a literal or class
+            int left, right;
+        };
+        vector<node> nodes;
+        int root;
+        string text;
+        string used;
+
+        int generate(mt19937 &random, int depth);
+        //bit i set for each end position i of a match of n from start
+        uint32_t ends(int n, const string &s, int start) const;
+};
+
+random_regex::random_regex(int seed) {
+    mt19937 random(seed);
+    root = generate(random, 4);
+    for (const node &n : nodes) {
+        for (char c : n.symbols) {
+            if (used.find(c) == string::npos) used += c;
+        }
+    }
+}
+
+int random_regex::generate(mt19937 &random, int depth) {
+    auto below = [&](int n) { return uniform_int_distribution<int>(0, n - 1)(random); };
+    node n{0, "", -1, -1};
+    int choice = depth > 0 && below(4) ? 4 + below(4) : below(4); //mostly inner nodes
+    if (choice == 0 || choice == 1) {
+        n.kind = 'l';
+        n.symbols = string(1, 'a' + below(3));
+        text += n.symbols;
+    } else if (choice == 2) {
+        n.kind = 'l';
+        if (below(2)) {
+            n.symbols = below(2) ? "abc" : "ab";
+            text += n.symbols == "abc" ? "[a-c]" : "[a-b]";
+        } else {
+            for (char c : string("abc")) {
+                if (below(2)) n.symbols += c;
+            }
+            if (n.symbols.empty()) n.symbols = "c";
+            text += "[" + n.symbols + "]";
+        }
+    } else if (choice == 3) {
+        n.kind = below(4) ? '.' : 'e';
+        if (n.kind == '.') text += ".";
+    } else if (choice == 4 || choice == 5) {
+        n.kind = 'c';
+        n.left = generate(random, depth - 1);
+        n.right = generate(random, depth - 1);
+    } else if (choice == 6) {
+        n.kind = '|';
+        text += "(";
+        n.left = generate(random, depth - 1);
+        text += "|";
+        n.right = generate(random, depth - 1);
+        text += ")";
+    } else {
+        n.kind = "*+?"[below(3)];
+        text += "(";
+        n.left = generate(random, depth - 1);
+        text += string(")") + n.kind;
+    }
+    nodes.push_back(n);
+    return nodes.size() - 1;
+}
+
+uint32_t random_regex::ends(int n, const string &s, int start) const {
+    const node &at = nodes[n];
+    auto step = [&](uint32_t from, int child) {
+        uint32_t to = 0;
+        for (int i = 0; i <= (int) s.size(); i++) {
+            if ((from >> i) & 1) to |= ends(child, s, i);
+        }
+        return to;
+    };
+    auto repeat = [&](uint32_t reached) {
+        while (true) {
+            uint32_t more = reached | step(reached, at.left);
+            if (more == reached) return reached;
+            reached = more;
+        }
+    };
+
+    uint32_t here = uint32_t(1) << start;
+    bool symbol = start < (int) s.size();
+    switch (at.kind) {
+        case 'l': return symbol && at.symbols.find(s[start]) != string::npos ? here << 1 : 0;
+        case '.': return symbol && used.find(s[start]) != string::npos ? here << 1 : 0;
+        case 'e': return here;
+        case 'c': return step(ends(at.left, s, start), at.right);
+        case '|': return ends(at.left, s, start) | ends(at.right, s, start);
+        case '*': return repeat(here);
+        case '+': return repeat(ends(at.left, s, start));
+        default:  return here | ends(at.left, s, start); //'?'
+    }
+}
+
+//benchmark suite ----------------------------------------------
+//times every phase of a conversion over each generated family, and prints
+//one record per case as csv or json
+void bench_suite(const string &format) {
+    struct bench_case {
+        const char* family;
+        generated_nfa (*generate)(int);
+        int size;
+    };
+    const bench_case cases[] = {
+        {"nth_from_end", nth_from_end_nfa, 8},
+        {"nth_from_end", nth_from_end_nfa, 12},
+        {"nth_from_end", nth_from_end_nfa, 16},
+        {"random_sparse", random_sparse_nfa, 100},
+        {"random_sparse", random_sparse_nfa, 1000},
+        {"epsilon_chain", epsilon_chain_nfa, 1000},
+        {"epsilon_chain", epsilon_chain_nfa, 10000},
+        {"large_alphabet", large_alphabet_nfa, 256},
+        {"large_alphabet", large_alphabet_nfa, 4096},
+        {"long_path", long_path_nfa, 10000},
+        {"long_path", long_path_nfa, 30000},
+    };
+    const char* columns[] = {
+        "family", "size", "nfa_states", "nfa_transitions", "dfa_states", "minimized_states",
+        "parse_seconds", "closure_seconds", "construct_seconds", "minimize_seconds", 
+        "output_seconds"
+    };
+
+    ScratchDirectory scratch("nfa_bench");
+    string nfa_file = scratch.file("case.nfa");
+    string output_file = scratch.file("case");
+
+    bool json = format == "json";
+    if (json) cout << "[" << endl;
+    else {
+        for (int c = 0; c < 11; c++) cout << (c ? "," : "") << columns[c];
+        cout << endl;
+    }
+
+    int count = sizeof(cases) / sizeof(cases[0]);
+    for (int i = 0; i < count; i++) {
+        cases[i].generate(cases[i].size).write(nfa_file);
+
+        NFA nfa(nfa_file);
+        auto begin = chrono::steady_clock::now();
+        DFA dfa(nfa);
+        auto constructed = chrono::steady_clock::now();
+        dfa.print_to_file(output_file);
+        auto written = chrono::steady_clock::now();
+        int dfa_states = dfa.state_count();
+        dfa.minimize();
+        auto minimized = chrono::steady_clock::now();
+
+        auto seconds = [](chrono::steady_clock::time_point from, chrono::steady_clock::time_point to) {
+            return to_string(chrono::duration<double>(to - from).count());
+        };
+        string values[] = {
+            cases[i].family, to_string(cases[i].size), to_string(nfa.universe), 
+            to_string(nfa.edges.size()), to_string(dfa_states), to_string(dfa.state_count()),
+            to_string(nfa.parse_seconds), to_string(nfa.closure_seconds), 
+            seconds(begin, constructed), seconds(written, minimized), seconds(constructed, written)
+        };
+
+        if (json) {
+            cout << "  {";
+            for (int c = 0; c < 11; c++) {
+                cout << (c ? ", " : "") << "\"" << columns[c] << "\": ";
+                if (c == 0) cout << "\"" << values[c] << "\"";
+                else cout << values[c];
+            }
+            cout << (i + 1 < count ? "}," : "}") << endl;
+        } else {
+            for (int c = 0; c < 11; c++) cout << (c ? "," : "") << values[c];
+            cout << endl;
+        }
+    }
+    if (json) cout << "]" << endl;
+}
+
+//glushkov against thompson over the same patterns: building each nfa,
+//its epsilon closures, and the subset construction from it. the two dfas
+//of each pattern must accept the same language
+void bench_regex() {
+    vector<string> patterns = {
+        "(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)",
+        "((a|b)*c(a|b)*c)*(a|b)*",
+        "((a*b*)*c*)*d",
+        "(abc|abd|acd|bcd|bce|cde)+(x|y)*z?",
+        "[a-z]*(foo|bar|baz|qux)[0-9]+(\\.[0-9]+)?",
+    };
+    //a long alternation of words, as generated by keyword lists
+    string words;
+    for (int i = 0; i < 300; i++) words += (i ? "|" : "") + string("w") + to_string(i * 7919 % 100000);
+    patterns.push_back("(" + words + ")+");
+
+    cout << "pattern,construction,nfa_states,nfa_edges,build_seconds,closure_seconds,"
+         << "construct_seconds,dfa_states" << endl;
+    for (int p = 0; p < (int) patterns.size(); p++) {
+        unique_ptr<NFA> nfas[2];
+        unique_ptr<DFA> dfas[2];
+        for (bool thompson : {false, true}) {
+            nfas[thompson].reset(new NFA(NFA::from_regex(patterns[p], thompson)));
+            const NFA &nfa = *nfas[thompson];
+            auto begin = chrono::steady_clock::now();
+            dfas[thompson].reset(new DFA(nfa));
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+
+            cout << "p" << p << "," << (thompson ? "thompson" : "glushkov") << "," 
+                 << nfa.universe << "," << nfa.edges.size() << "," << nfa.parse_seconds << ","
+                 << nfa.closure_seconds << "," << elapsed.count() << "," 
+                 << dfas[thompson]->state_count() << endl;
+        }
+
+        //both constructions number the alphabet by first use in the pattern
+        if (nfas[0]->alphabet != nfas[1]->alphabet) {
+            cerr << "p" << p << ": glushkov and thompson alphabets differ!" << endl;
+            exit(EXIT_FAILURE);
+        }
+        DFAView glushkov(*dfas[0]), thompson(*dfas[1]);
+        vector<int> symbols(nfas[0]->alphabet.size());
+        for (size_t a = 0; a < symbols.size(); a++) symbols[a] = a;
+        equivalence_result result = check_equivalence(glushkov, thompson, symbols);
+        if (!result.equivalent) {
+            cerr << "p" << p << ": ";
+            report_equivalence(result, nfas[0]->alphabet, "the glushkov dfa", "the thompson dfa");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+//each simulation kernel that fits the nfa against the compiled dfa, over
+//the lines of input_file. the dfa is timed building and matching apart, 
+//and is skipped if it passes a million states. every engine must agree
+void bench_sim(const NFA &nfa, const string &input_file) {
+    MappedFile input(input_file);
+    vector<string_view> lines = split_lines(input);
+
+    vector<uint8_t> expected;
+    string fastest;
+    double fastest_seconds = 0;
+    auto run = [&](const string &engine, auto &matcher, double build_seconds) {
+        vector<uint8_t> results(lines.size());
+        auto begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < lines.size(); i++) {
+            results[i] = matcher.matches(lines[i].data(), lines[i].data() + lines[i].size());
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+        cout << engine << "\t" << build_seconds << "\t" << elapsed.count() << "\t" 
+             << input.size() / elapsed.count() / 1e6 << endl;
+        if (fastest.empty() || build_seconds + elapsed.count() < fastest_seconds) {
+            fastest = engine;
+            fastest_seconds = build_seconds + elapsed.count();
+        }
+
+        if (expected.empty()) expected = results;
+        else if (results != expected) {
+            cerr << engine << " results differ!" << endl;
+            exit(EXIT_FAILURE);
+        }
+    };
+
+    cout << "engine\tbuild_seconds\tmatch_seconds\tMB/s" << endl;
+    using Kernel = NFASimulator::Kernel;
+    for (Kernel kernel : {Kernel::shift_and, Kernel::masks, Kernel::direct}) {
+        auto begin = chrono::steady_clock::now();
+        NFASimulator simulator(nfa, kernel);
+        chrono::duration<double> built = chrono::steady_clock::now() - begin;
+        if (simulator.kernel() != kernel) continue;
+        run(NFASimulator::kernel_name(kernel), simulator, built.count());
+    }
+
+    ConversionLimits limits;
+    limits.max_states = 1 << 20;
+    auto begin = chrono::steady_clock::now();
+    DFA dfa(nfa, ExploreOrder::depth_first, 1, limits);
+    if (!dfa.complete()) {
+        cout << "dfa\tstopped at " << dfa.result().status_name() << endl;
+    } else {
+        CompiledDFA compiled(dfa);
+        chrono::duration<double> built = chrono::steady_clock::now() - begin;
+        run("dfa", compiled, built.count());
+    }
+    //building counts, so short inputs can favour simulation
+    cout << "fastest: " << fastest << endl;
+}
+
+//heap allocations made by subset construction, per dfa state built. each
+//state's subset and transition row come out of arenas, so past the first
+//few states the count per state should fall towards zero, leaving only
+//the amortized growth of the id indexed vectors
+void bench_allocs() {
+#if NFA_DFA_STATS && NFA_DFA_COUNT_ALLOCS
+    struct bench_case {
+        const char* family;
+        generated_nfa (*generate)(int);
+        int size;
+    };
+    const bench_case cases[] = {
+        {"nth_from_end", nth_from_end_nfa, 8},
+        {"nth_from_end", nth_from_end_nfa, 12},
+        {"nth_from_end", nth_from_end_nfa, 16},
+        {"long_path", long_path_nfa, 1000},
+        {"long_path", long_path_nfa, 4000},
+        {"long_path", long_path_nfa, 16000},
+    };
+
+    ScratchDirectory scratch("nfa_bench");
+    string nfa_file = scratch.file("case.nfa");
+
+    cout << "family,size,dfa_states,heap_allocations,allocations_per_state" << endl;
+    for (const bench_case &c : cases) {
+        c.generate(c.size).write(nfa_file);
+        NFA nfa(nfa_file);
+
+        uint64_t before = thread_stats.heap_allocations;
+        int dfa_states;
+        {
+            DFA dfa(nfa);
+            dfa_states = dfa.state_count();
+        }
+        uint64_t allocations = thread_stats.heap_allocations - before;
+        cout << c.family << "," << c.size << "," << dfa_states << "," << allocations 
+             << "," << double(allocations) / dfa_states << endl;
+    }
+#else
+    cerr << "--bench-allocs needs a build with -DNFA_DFA_COUNT_ALLOCS=1" << endl;
+    exit(EXIT_FAILURE);
+#endif
+}
+
+//report on one conversion to cerr, as "name: value" lines or a json object.
+//on a cache hit the lookup is reported as construct_seconds
+void print_stats(const NFA &nfa, long dfa_states, bool cache_hit, double construct_seconds, 
+                 double minimize_seconds, double write_seconds, const string &format) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    vector<pair<string, string>> fields = {
+        {"parse_seconds", to_string(nfa.parse_seconds)},
+        {"closure_seconds", to_string(nfa.closure_seconds)},
+        {"construct_seconds", to_string(construct_seconds)},
+        {"minimize_seconds", to_string(minimize_seconds)},
+        {"write_seconds", to_string(write_seconds)},
+        {"nfa_states", to_string(nfa.universe)},
+        {"dfa_states", to_string(dfa_states)},
+        {"dfa_transitions", to_string(dfa_states * (long) nfa.alphabet.size())},
+        {"cache_hit", to_string(cache_hit)},
+        {"peak_rss_kb", to_string(usage.ru_maxrss)},
+    };
+#if NFA_DFA_STATS
+    STAT_MERGE();
+    fields.push_back({"peak_subset", to_string(merged_stats.peak_subset)});
+    fields.push_back({"intern_probes", to_string(merged_stats.intern_probes)});
+    fields.push_back({"intern_collisions", to_string(merged_stats.intern_collisions)});
+    fields.push_back({"closure_lookups", to_string(merged_stats.closure_lookups)});
+    fields.push_back({"closure_hits", to_string(merged_stats.closure_hits)});
+#if NFA_DFA_COUNT_ALLOCS
+    fields.push_back({"heap_allocations", to_string(merged_stats.heap_allocations)});
+#endif
+#endif
+
+    if (format == "json") {
+        cerr << "{";
+        for (size_t i = 0; i < fields.size(); i++) {
+            cerr << (i ? ", " : "") << "\"" << fields[i].first << "\": " << fields[i].second;
+        }
+        cerr << "}" << endl;
+    } else {
+        for (auto &field : fields) cerr << field.first << ": " << field.second << endl;
+    }
+}
+
+//conversion cache ------------------------------------------
+//converted dfas stored on disk as binary .dfab files named by a hash of
+//the nfa, so an nfa seen before is answered without determinizing it.
+//
+//the key covers everything the output depends on: the state labels in id
+//order, the alphabet in file order, the start and accept states, the 
+//transitions as a sorted set (so the order of transition lines does not 
+//matter) and the conversion options. entries are written to a temporary
+//file and renamed into place, so readers never see half an entry. a hit
+//refreshes the entry's mtime, and once the directory is over its byte 
+//limit the least recently used entries are deleted. the directory is only
+//scanned when this process's running total of its size says it is full,
+//so processes sharing a cache may overshoot by what the others stored
+//since their last scan. deletion holds an
+//exclusive flock on the directory's lock file and lookups a shared one
+//while they map an entry, so an entry can't vanish between the two
+class ConversionCache {
+    public:
+        ConversionCache(const string &directory, uint64_t byte_limit);
+
+        //the cache key of a conversion of nfa, as 32 hex digits
+        static string key(const NFA &nfa, ExploreOrder order, bool minimize);
+        //the stored dfa for key, or null on a miss
+        unique_ptr<CompiledDFA> find(const string &key) const;
+        void store(const string &key, const DFA &dfa) const;
+
+    private:
+        string entry_path(const string &key) const { return directory + "/" + key + ".dfab"; }
+        //open and flock the lock file. close the result to release it
+        int lock(int operation) const;
+        //delete entries until under the limit, returning the bytes left.
+        //temporary files older than stale_seconds go too
+        uint64_t evict() const;
+        static const int stale_seconds = 3600;
+
+        string directory;
+        uint64_t byte_limit;
+        mutable mutex size_lock;
+        mutable int64_t known_bytes = -1; //-1 until the first scan
+};
+
+ConversionCache::ConversionCache(const string &directory, uint64_t byte_limit)
+    : directory(directory), byte_limit(byte_limit) {
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        cerr << "can't create cache directory " << directory << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+//blake2b (rfc 7693) with a 16 byte digest and no key. a key collision
+//would answer one nfa with another's dfa, so the key needs a real 
+//cryptographic hash rather than a fast one
+static void blake2b_128(const string &message, uint8_t digest[16]) {
+    static const uint64_t iv[8] = {
+        0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+    };
+    static const uint8_t sigma[12][16] = {
+        { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+        {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+        {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+        { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+        { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+        { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+        {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+        {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+        { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+        {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0},
+        { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+        {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    };
+    auto rotate = [](uint64_t x, int n) { return (x >> n) | (x << (64 - n)); };
+
+    uint64_t h[8];
+    for (int i = 0; i < 8; i++) h[i] = iv[i];
+    h[0] ^= 0x01010000 ^ 16;
+
+    //every block is compressed with the count of bytes so far. the last,
+    //zero padded, is flagged as the last (an empty message is one block)
+    auto compress = [&](const uint8_t* block, uint64_t counted, bool last) {
+        uint64_t m[16], v[16];
+        for (int i = 0; i < 16; i++) {
+            m[i] = 0;
+            for (int b = 7; b >= 0; b--) m[i] = m[i] << 8 | block[i * 8 + b];
+        }
+        for (int i = 0; i < 8; i++) {
+            v[i] = h[i];
+            v[i + 8] = iv[i];
+        }
+        v[12] ^= counted;
+        if (last) v[14] = ~v[14];
+        auto mix = [&](int a, int b, int c, int d, uint64_t x, uint64_t y) {
+            v[a] = v[a] + v[b] + x; v[d] = rotate(v[d] ^ v[a], 32);
+            v[c] = v[c] + v[d];     v[b] = rotate(v[b] ^ v[c], 24);
+            v[a] = v[a] + v[b] + y; v[d] = rotate(v[d] ^ v[a], 16);
+            v[c] = v[c] + v[d];     v[b] = rotate(v[b] ^ v[c], 63);
+        };
+        for (int r = 0; r < 12; r++) {
+            const uint8_t* s = sigma[r];
+            mix(0, 4,  8, 12, m[s[0]],  m[s[1]]);
+            mix(1, 5,  9, 13, m[s[2]],  m[s[3]]);
+            mix(2, 6, 10, 14, m[s[4]],  m[s[5]]);
+            mix(3, 7, 11, 15, m[s[6]],  m[s[7]]);
+            mix(0, 5, 10, 15, m[s[8]],  m[s[9]]);
+            mix(1, 6, 11, 12, m[s[10]], m[s[11]]);
+            mix(2, 7,  8, 13, m[s[12]], m[s[13]]);
+            mix(3, 4,  9, 14, m[s[14]], m[s[15]]);
+        }
+        for (int i = 0; i < 8; i++) h[i] ^= v[i] ^ v[i + 8];
+    };
+
+    const uint8_t* bytes = (const uint8_t*) message.data();
+    size_t offset = 0;
+    while (message.size() - offset > 128) {
+        compress(bytes + offset, offset + 128, false);
+        offset += 128;
+    }
+    uint8_t last[128] = {0};
+    memcpy(last, bytes + offset, message.size() - offset);
+    compress(last, message.size(), true);
+
+    for (int i = 0; i < 16; i++) digest[i] = h[i / 8] >> (8 * (i % 8));
+}
+
+string ConversionCache::key(const NFA &nfa, ExploreOrder order, bool minimize) {
+    //canonical byte string of the nfa, hashed with blake2b
+    string canonical = "nfa-dfa cache 2\n";
+    canonical += order == ExploreOrder::breadth_first ? "bfs" : "dfs";
+    canonical += minimize ? " minimized\n" : "\n";
+    auto put_int = [&](int64_t value) { canonical.append((const char*) &value, sizeof(value)); };
+    auto put_string = [&](const string &text) { put_int(text.size()); canonical += text; };
+
+    put_int(nfa.state_names.size());
+    for (const string &name : nfa.state_names) put_string(name);
+    put_int(nfa.alphabet.size());
+    for (const string &symbol : nfa.alphabet) put_string(symbol);
+    put_int(nfa.start_state);
+
+    vector<int> accepts = nfa.accept_states;
+    sort(accepts.begin(), accepts.end());
+    accepts.erase(unique(accepts.begin(), accepts.end()), accepts.end());
+    put_int(accepts.size());
+    for (int state : accepts) put_int(state);
+
+    vector<tuple<int, int, int>> edges;
+    for (const NFA::edge &e : nfa.edges) edges.emplace_back(e.from, e.symbol, e.to);
+    sort(edges.begin(), edges.end());
+    edges.erase(unique(edges.begin(), edges.end()), edges.end());
+    put_int(edges.size());
+    for (auto &e : edges) {
+        put_int(get<0>(e));
+        put_int(get<1>(e));
+        put_int(get<2>(e));
+    }
+
+    uint8_t digest[16];
+    blake2b_128(canonical, digest);
+    char hex[33];
+    for (int i = 0; i < 16; i++) snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+    return hex;
+}
+
+int ConversionCache::lock(int operation) const {
+    string lock_file = directory + "/lock";
+    int fd = open(lock_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || flock(fd, operation) != 0) {
+        cerr << "can't lock " << lock_file << endl;
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+//an entry that doesn't load is a miss, and is deleted so the conversion
+//stores a good one. entries are checked down to every table entry, since
+//a damaged one would otherwise be matched against out of bounds
+unique_ptr<CompiledDFA> ConversionCache::find(const string &key) const {
+    string path = entry_path(key);
+    int fd = lock(LOCK_SH);
+    unique_ptr<CompiledDFA> found;
+    bool damaged = false;
+    struct stat entry;
+    if (stat(path.c_str(), &entry) == 0) {
+        string error;
+        found = CompiledDFA::load(path, error, true);
+        if (found) utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+        else {
+            cerr << "cache entry " << path << ": " << error << ", removing it" << endl;
+            damaged = true;
+        }
+    }
+    close(fd);
+
+    //unless another process has stored a new entry there in the meantime
+    if (damaged) {
+        fd = lock(LOCK_EX);
+        struct stat now;
+        if (stat(path.c_str(), &now) == 0 && now.st_ino == entry.st_ino) unlink(path.c_str());
+        close(fd);
+    }
+    return found;
+}
+
+void ConversionCache::store(const string &key, const DFA &dfa) const {
+    static atomic<int> sequence(0);
+    string temporary = directory + "/.tmp-" + key + "-" + to_string(getpid()) 
+                       + "-" + to_string(sequence++);
+    dfa.print_binary(temporary);
+    struct stat info;
+    if (stat((temporary + ".dfab").c_str(), &info) != 0 
+        || rename((temporary + ".dfab").c_str(), entry_path(key).c_str()) != 0) {
+        cerr << "can't store " << entry_path(key) << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    lock_guard<mutex> guard(size_lock);
+    if (known_bytes < 0 || known_bytes + info.st_size > (int64_t) byte_limit) known_bytes = evict();
+    else known_bytes += info.st_size;
+}
+
+uint64_t ConversionCache::evict() const {
+    int fd = lock(LOCK_EX);
+
+    vector<pair<timespec, string>> entries;
+    uint64_t total = 0;
+    DIR* listing = opendir(directory.c_str());
+    while (listing != nullptr) {
+        struct dirent* entry = readdir(listing);
+        if (entry == nullptr) break;
+        string name = entry->d_name;
+        struct stat info;
+        string path = directory + "/" + name;
+
+        //a writer that died leaves its temporary file behind. one this old
+        //can't still be being written
+        if (name.compare(0, 5, ".tmp-") == 0) {
+            if (stat(path.c_str(), &info) == 0 && time(nullptr) - info.st_mtime > stale_seconds) {
+                unlink(path.c_str());
+            }
+            continue;
+        }
+        if (name[0] == '.' || name.size() < 5 || name.compare(name.size() - 5, 5, ".dfab") != 0) continue;
+
+        if (stat(path.c_str(), &info) != 0) continue;
+        total += info.st_size;
+        entries.push_back({info.st_mtim, path});
+    }
+    if (listing != nullptr) closedir(listing);
+
+    sort(entries.begin(), entries.end(), [](const pair<timespec, string> &a, const pair<timespec, string> &b) {
+        if (a.first.tv_sec != b.first.tv_sec) return a.first.tv_sec < b.first.tv_sec;
+        return a.first.tv_nsec < b.first.tv_nsec;
+    });
+    for (size_t i = 0; i < entries.size() && total > byte_limit; i++) {
+        struct stat info;
+        if (stat(entries[i].second.c_str(), &info) == 0 && unlink(entries[i].second.c_str()) == 0) {
+            total -= info.st_size;
+        }
+    }
+
+    close(fd);
+    return total;
+}
+
+//report a conversion that stopped at a limit, as "name: value" lines
+void print_result(const ConversionResult &result) {
+    cerr << "conversion: " << result.status_name() << endl;
+    cerr << "dfa states: " << result.states << endl;
+    cerr << "bytes: " << result.bytes << endl;
+    cerr << "seconds: " << result.seconds << endl;
+}
+
+//batch conversion ------------------------------------------
+//the nfa files named by spec: every .nfa file in a directory, the matches
+//of a glob pattern, or else the lines of a manifest file (blank lines and
+//lines starting with # are skipped). returned sorted, for stable output
+vector<string> batch_inputs(const string &spec) {
+    vector<string> inputs;
+    struct stat info;
+    if (stat(spec.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+        DIR* directory = opendir(spec.c_str());
+        if (directory == nullptr) {
+            cerr << "can't open " << spec << endl;
+            exit(EXIT_FAILURE);
+        }
+        while (struct dirent* entry = readdir(directory)) {
+            string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".nfa") == 0) {
+                inputs.push_back(spec + "/" + name);
+            }
+        }
+        closedir(directory);
+    } else if (spec.find_first_of("*?[") != string::npos) {
+        glob_t matches;
+        if (glob(spec.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++) inputs.push_back(matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+    } else {
+        ifstream manifest(spec);
+        if (!manifest) {
+            cerr << "can't open " << spec << endl;
+            exit(EXIT_FAILURE);
+        }
+        string line;
+        while (getline(manifest, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line[0] != '#') inputs.push_back(line);
+        }
+    }
+
+    sort(inputs.begin(), inputs.end());
+    return inputs;
+}
+
+//where the dfa for input goes, without the .dfa extension: input minus its
+//.nfa extension, moved into out_dir when one is given
+string batch_output(const string &input, const string &out_dir) {
+    string stem = input;
+    if (stem.size() > 4 && stem.compare(stem.size() - 4, 4, ".nfa") == 0) stem.resize(stem.size() - 4);
+    if (out_dir.empty()) return stem;
+    size_t slash = stem.rfind('/');
+    return out_dir + "/" + (slash == string::npos ? stem : stem.substr(slash + 1));
+}
+
+//convert every input in one process. jobs worker threads claim inputs off
+//an atomic cursor and each converts its files start to finish, printing a
+//line per file as it completes. a malformed input or one that stops at a
+//limit only skips its file. returns nonzero if any input was malformed.
+//cache may be null
+int convert_batch(const string &spec, const string &out_dir, int jobs, ExploreOrder order,
+                   const ConversionLimits &limits, bool minimize, bool binary_output, 
+                   const ConversionCache* cache) {
+    vector<string> inputs = batch_inputs(spec);
+    if (inputs.empty()) {
+        cerr << "no nfa files in " << spec << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    atomic<size_t> cursor(0);
+    atomic<long> total_states(0);
+    atomic<long> cache_hits(0);
+    atomic<long> stopped(0);
+    atomic<long> failed(0);
+    mutex print_lock;
+    auto begin = chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = cursor.fetch_add(1)) < inputs.size()) {
+            auto started = chrono::steady_clock::now();
+            unique_ptr<NFA> parsed;
+            try {
+                parsed.reset(new NFA(inputs[i], false));
+            } catch (const NFAError &error) {
+                failed++;
+                lock_guard<mutex> guard(print_lock);
+                cout << inputs[i] << " failed: " << error.message << endl;
+                continue;
+            }
+            const NFA &nfa = *parsed;
+            string output = batch_output(inputs[i], out_dir);
+            string key;
+            unique_ptr<CompiledDFA> cached;
+            if (cache != nullptr) {
+                key = ConversionCache::key(nfa, order, minimize);
+                cached = cache->find(key);
+            }
+
+            int state_count;
+            if (cached) {
+                cached->print_to_file(output);
+                if (binary_output) cached->save(output + ".dfab", string(cached->dictionary()));
+                state_count = cached->state_count() - 1; //less the sink
+                cache_hits++;
+            } else {
+                DFA dfa(nfa, order, 1, limits);
+                if (!dfa.complete()) {
+                    stopped++;
+                    lock_guard<mutex> guard(print_lock);
+                    cout << inputs[i] << " stopped at " << dfa.result().status_name() << " (" 
+                         << dfa.result().states << " states, " << dfa.result().seconds << " s)" << endl;
+                    continue;
+                }
+                if (minimize) dfa.minimize();
+                dfa.print_to_file(output);
+                if (binary_output) dfa.print_binary(output);
+                if (cache != nullptr) cache->store(key, dfa);
+                state_count = dfa.state_count();
+            }
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - started;
+            total_states += state_count;
+
+            lock_guard<mutex> guard(print_lock);
+            cout << inputs[i] << " -> " << output << ".dfa (" << state_count 
+                 << " states, " << elapsed.count() << " s" << (cached ? ", cached)" : ")") << endl;
+        }
+        STAT_MERGE();
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < jobs; t++) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+
+    cerr << "files: " << inputs.size() << endl;
+    cerr << "dfa states: " << total_states.load() << endl;
+    if (cache != nullptr) cerr << "cache hits: " << cache_hits.load() << endl;
+    cerr << "stopped at a limit: " << stopped.load() << endl;
+    cerr << "malformed: " << failed.load() << endl;
+    cerr << "seconds: " << elapsed.count() << endl;
+    cerr << "throughput: " << inputs.size() / elapsed.count() << " files/s" << endl;
+    return failed > 0 ? EXIT_FAILURE : 0;
+}
+
+//verification suite ----------------------------------------
+//convert count random small nfas every way the converter can, serial and
+//on four threads, in both orders, then minimized, and check each dfa 
+//against its nfa. then edit each nfa with two random deltas in turn,
+//updating the dfa in both orders, in place and renumbered. each update
+//is checked, along with its state count against a fresh conversion, and
+//then minimized and checked again. the first nfa that fails is kept as
+//verify_failure.nfa, with its deltas as verify_failure.delta and .delta2.
+//
+//everything else that answers for an nfa is checked against its eager
+//dfa: the dfa saved as a binary file and loaded back, and stored in and 
+//found in a cache, for equivalence; and on random strings, the lazy dfa 
+//with a budget that flushes on nearly every step and with the default one,
+//and each simulation kernel that fits. a random regex per seed is built
+//both ways and matched against random_regex's own matcher
+void verify_suite(int count) {
+    ScratchDirectory scratch("nfa_verify");
+    string nfa_file = scratch.file("case.nfa");
+    string delta_file = scratch.file("case.delta");
+    string second_delta_file = scratch.file("case.delta2");
+    string binary_file = scratch.file("case");
+    ScratchDirectory cache_directory("nfa_verify_cache");
+    ConversionCache cache(cache_directory.directory(), uint64_t(256) << 20);
+
+    auto fail = [&](int seed, const string &what) {
+        random_small_nfa(seed).write("verify_failure.nfa");
+        cerr << "seed " << seed << ", " << what << ": written to verify_failure.nfa" << endl;
+        exit(EXIT_FAILURE);
+    };
+
+    auto begin = chrono::steady_clock::now();
+    int checked = 0;
+    long matched = 0;
+    for (int seed = 0; seed < count; seed++) {
+        random_small_nfa(seed).write(nfa_file);
+        NFA nfa(nfa_file);
+        mt19937 random(seed);
+        auto below = [&](int n) { return uniform_int_distribution<int>(0, n - 1)(random); };
+        for (int threads : {1, 4}) {
+            for (ExploreOrder order : {ExploreOrder::depth_first, ExploreOrder::breadth_first}) {
+                DFA dfa(nfa, order, threads);
+                bool ok = verify_dfa(nfa, dfa, true);
+                if (ok) {
+                    dfa.minimize();
+                    ok = verify_dfa(nfa, dfa, true);
+                }
+                checked += 2;
+                if (!ok) {
+                    fail(seed, to_string(threads) + " threads, " 
+                               + (order == ExploreOrder::depth_first ? "dfs" : "bfs"));
+                }
+            }
+        }
+
+        DFA eager(nfa);
+        CompiledDFA compiled(eager);
+        vector<int> symbols(nfa.alphabet.size());
+        for (size_t a = 0; a < symbols.size(); a++) symbols[a] = a;
+        auto same_as_eager = [&](const CompiledDFA &other) {
+            if (other.column_count() != nfa.class_count() + 1) return false;
+            DFAView reference(eager);
+            ClassView converted(other, nfa);
+            return check_equivalence(reference, converted, symbols).equivalent;
+        };
+
+        eager.print_binary(binary_file);
+        string error;
+        unique_ptr<CompiledDFA> loaded = CompiledDFA::load(binary_file + ".dfab", error, true);
+        if (!loaded || !same_as_eager(*loaded)) fail(seed, "saved and loaded" + (error.empty() ? "" : ": " + error));
+        string key = ConversionCache::key(nfa, ExploreOrder::depth_first, false);
+        cache.store(key, eager);
+        unique_ptr<CompiledDFA> cached = cache.find(key);
+        if (!cached || !same_as_eager(*cached)) fail(seed, "cached");
+        checked += 2;
+
+        //strings over the alphabet, and now and then a byte outside it
+        vector<string> inputs(20);
+        for (string &input : inputs) {
+            for (int i = below(13); i > 0; i--) {
+                input += below(10) ? nfa.alphabet[below(nfa.alphabet.size())][0] : 'z';
+            }
+        }
+        LazyDFA thrashing(nfa, 1), lazy(nfa);
+        using Kernel = NFASimulator::Kernel;
+        vector<NFASimulator> simulators;
+        for (Kernel kernel : {Kernel::shift_and, Kernel::masks, Kernel::direct}) {
+            simulators.emplace_back(nfa, kernel);
+            if (simulators.back().kernel() != kernel) simulators.pop_back();
+        }
+        for (const string &input : inputs) {
+            const char* first = input.data();
+            const char* last = first + input.size();
+            bool expected = compiled.matches(first, last);
+            if (thrashing.matches(first, last) != expected) fail(seed, "lazy dfa, tiny budget, \"" + input + "\"");
+            if (lazy.matches(first, last) != expected) fail(seed, "lazy dfa, \"" + input + "\"");
+            for (const NFASimulator &simulator : simulators) {
+                if (simulator.matches(first, last) != expected) {
+                    fail(seed, string(NFASimulator::kernel_name(simulator.kernel())) 
+                               + " simulation, \"" + input + "\"");
+                }
+            }
+            matched += 2 + simulators.size();
+        }
+
+        random_regex regex(seed);
+        for (bool thompson : {false, true}) {
+            NFA regex_nfa = NFA::from_regex(regex.pattern(), thompson);
+            CompiledDFA regex_dfa{DFA(regex_nfa)};
+            for (int i = 0; i < 20; i++) {
+                string input;
+                for (int j = below(9); j > 0; j--) input += below(10) ? 'a' + below(3) : 'z';
+                if (regex_dfa.matches(input.data(), input.data() + input.size()) != regex.matches(input)) {
+                    cerr << "seed " << seed << ": " << (thompson ? "thompson" : "glushkov") 
+                         << " dfa of regex \"" << regex.pattern() << "\" disagrees on \"" 
+                         << input << "\"" << endl;
+                    exit(EXIT_FAILURE);
+                }
+                matched++;
+            }
+            checked++;
+        }
+
+        write_random_delta(random_small_nfa(seed), seed, delta_file);
+        write_random_delta(random_small_nfa(seed), ~seed, second_delta_file);
+        for (int variant = 0; variant < 4; variant++) {
+            ExploreOrder order = variant & 1 ? ExploreOrder::breadth_first : ExploreOrder::depth_first;
+            NFA edited(nfa_file);
+            DFA dfa(edited, order);
+            int step = 0;
+            bool ok = true;
+            for (const string &delta : {delta_file, second_delta_file}) {
+                dfa.update(edited, edited.apply(delta), variant & 2);
+                ok = ok && verify_dfa(edited, dfa, true) && dfa.state_count() == DFA(edited, order).state_count();
+                step += ok;
+                checked++;
+            }
+            if (ok) {
+                dfa.minimize();
+                ok = verify_dfa(edited, dfa, true);
+                checked++;
+            }
+            if (!ok) {
+                random_small_nfa(seed).write("verify_failure.nfa");
+                write_random_delta(random_small_nfa(seed), seed, "verify_failure.delta");
+                write_random_delta(random_small_nfa(seed), ~seed, "verify_failure.delta2");
+                cerr << "seed " << seed << ", " << (step == 2 ? "minimized after " : "")
+                     << "update " << min(step + 1, 2) << (variant & 2 ? ", renumbered, " : ", ")
+                     << (order == ExploreOrder::depth_first ? "dfs" : "bfs") 
+                     << ": written to verify_failure.nfa, .delta and .delta2" << endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+    cerr << "verified " << checked << " dfas and " << matched << " matches from " << count 
+         << " nfas and regexes in " << elapsed.count() << " seconds" << endl;
+}
+
+//main ------------------------------------------------------
+int main (int argc, char** argv) {
+
+    //look for a file from which to create nfa, plus any options
+    string nfa_file = "";
+    ExploreOrder order = ExploreOrder::depth_first;
+    int threads = 1;
+    bool minimize = false;
+    bool benchmark_threads = false;
+    bool benchmark_parse = false;
+    bool benchmark_output = false;
+    bool benchmark_allocs = false;
+    bool benchmark_regex = false;
+    string sim_bench_input = "";
+    string delta_file = "";
+    bool renumber = false;
+    bool verify = false;
+    int verify_count = 0;
+    vector<string> verify_binaries;
+    string regex = "";
+    bool thompson = false;
+    string suite_format = "";
+    string stats_format = "";
+    string batch_spec = "";
+    string out_dir = "";
+    int jobs = max(1, (int) thread::hardware_concurrency());
+    string cache_dir = "";
+    uint64_t cache_limit = uint64_t(256) << 20;
+    ConversionLimits limits;
+    string lazy_input = "";
+    string match_input = "";
+    string batch_bench_input = "";
+    string binary_input = "";
+    bool binary_output = false;
+    string header_name = "";
+    HeaderStyle header_style = HeaderStyle::table;
+    string codegen_bench_input = "";
+    size_t cache_bytes = 1 << 20;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--order=bfs") order = ExploreOrder::breadth_first;
+        else if (arg == "--order=dfs") order = ExploreOrder::depth_first;
+        else if (arg == "--threads" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+        else if (arg == "--minimize") minimize = true;
+        else if (arg == "--bench-threads") benchmark_threads = true;
+        else if (arg == "--bench-parse") benchmark_parse = true;
+        else if (arg == "--bench-output") benchmark_output = true;
+        else if (arg == "--bench-allocs") benchmark_allocs = true;
+        else if (arg == "--bench-regex") benchmark_regex = true;
+        else if (arg == "--bench-sim" && i + 1 < argc) sim_bench_input = argv[++i];
+        else if (arg == "--verify") verify = true;
+        else if (arg == "--delta" && i + 1 < argc) delta_file = argv[++i];
+        else if (arg == "--renumber") renumber = true;
+        else if (arg == "--verify-suite" && i + 1 < argc) verify_count = max(1, atoi(argv[++i]));
+        else if (arg == "--verify-binary" && i + 2 < argc) {
+            verify_binaries = {argv[i + 1], argv[i + 2]};
+            i += 2;
+        }
+        else if (arg == "--regex" && i + 1 < argc) regex = argv[++i];
+        else if (arg == "--thompson") thompson = true;
+        else if (arg == "--bench-suite" || arg == "--bench-suite=csv") suite_format = "csv";
+        else if (arg == "--bench-suite=json") suite_format = "json";
+        else if (arg == "--stats" || arg == "--stats=text") stats_format = "text";
+        else if (arg == "--stats=json") stats_format = "json";
+        else if (arg == "--batch" && i + 1 < argc) batch_spec = argv[++i];
+        else if (arg == "--out-dir" && i + 1 < argc) out_dir = argv[++i];
+        else if (arg == "--jobs" && i + 1 < argc) jobs = max(1, atoi(argv[++i]));
+        else if (arg == "--cache" && i + 1 < argc) cache_dir = argv[++i];
+        else if (arg == "--cache-limit" && i + 1 < argc) cache_limit = atoll(argv[++i]);
+        else if (arg == "--max-states" && i + 1 < argc) limits.max_states = atoi(argv[++i]);
+        else if (arg == "--max-memory" && i + 1 < argc) limits.max_bytes = atoll(argv[++i]);
+        else if (arg == "--max-seconds" && i + 1 < argc) limits.max_seconds = atof(argv[++i]);
+        else if (arg == "--lazy-match" && i + 1 < argc) lazy_input = argv[++i];
+        else if (arg == "--match" && i + 1 < argc) match_input = argv[++i];
+        else if (arg == "--bench-batch" && i + 1 < argc) batch_bench_input = argv[++i];
+        else if (arg == "--binary") binary_output = true;
+        else if (arg == "--header" && i + 1 < argc) header_name = argv[++i];
+        else if (arg == "--header-style=table") header_style = HeaderStyle::table;
+        else if (arg == "--header-style=goto") header_style = HeaderStyle::goto_switch;
+        else if (arg == "--bench-codegen" && i + 1 < argc) codegen_bench_input = argv[++i];
+        else if (arg == "--load-binary" && i + 1 < argc) binary_input = argv[++i];
+        else if (arg == "--cache-bytes" && i + 1 < argc) cache_bytes = atoll(argv[++i]);
+        else if (arg.rfind("--", 0) == 0) {
+            cerr << "unknown option " << arg << endl;
+            exit(EXIT_FAILURE);
+        } else nfa_file = arg;
+    }
+
+    if (!suite_format.empty()) {
+        bench_suite(suite_format);
+        return 0;
+    }
+    if (benchmark_allocs) {
+        bench_allocs();
+        return 0;
+    }
+    if (benchmark_regex) {
+        bench_regex();
+        return 0;
+    }
+    if (verify_count > 0) {
+        verify_suite(verify_count);
+        return 0;
+    }
+    if (!verify_binaries.empty()) {
+        CompiledDFA left(verify_binaries[0], true), right(verify_binaries[1], true);
+        return verify_compiled(left, right) ? 0 : EXIT_FAILURE;
+    }
+
+    unique_ptr<ConversionCache> cache;
+    if (!cache_dir.empty()) cache.reset(new ConversionCache(cache_dir, cache_limit));
+
+    if (!batch_spec.empty()) {
+        return convert_batch(batch_spec, out_dir, jobs, order, limits, minimize, 
+                             binary_output, cache.get());
+    }
+
+    //a compiled dfa can be matched against without any nfa
+    if (!binary_input.empty()) {
+        CompiledDFA compiled(binary_input, verify);
+        if (!match_input.empty()) match_file(compiled, match_input);
+        else if (!batch_bench_input.empty()) bench_batch(compiled, batch_bench_input);
+        else if (!codegen_bench_input.empty()) bench_codegen(compiled, codegen_bench_input);
+        else if (!header_name.empty()) compiled.print_header("converted_dfa", header_name, header_style);
+        else cerr << "loaded " << compiled.state_count() << " states" << (verify ? ", every entry checked" : "") << endl;
+        return 0;
+    }
+
+    if (nfa_file.empty() && regex.empty()) {
+        cerr << "requires file name!" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (benchmark_parse) {
+        bench_parse(nfa_file);
+        return 0;
+    }
+
+    //create nfa from file, or straight from a regex
+    NFA my_NFA = regex.empty() ? NFA(nfa_file) : NFA::from_regex(regex, thompson);
+    if (benchmark_threads) {
+        bench_threads(my_NFA, order);
+        return 0;
+    }
+    if (benchmark_output) {
+        bench_output(my_NFA, order);
+        return 0;
+    }
+    if (!lazy_input.empty()) {
+        lazy_match_file(my_NFA, lazy_input, cache_bytes);
+        return 0;
+    }
+    if (!sim_bench_input.empty()) {
+        bench_sim(my_NFA, sim_bench_input);
+        return 0;
+    }
+
+    //an nfa converted before is answered from the cache
+    string cache_key;
+    if (cache && delta_file.empty()) {
+        cache_key = ConversionCache::key(my_NFA, order, minimize);
+        auto lookup_begin = chrono::steady_clock::now();
+        if (unique_ptr<CompiledDFA> cached = cache->find(cache_key)) {
+            if (verify) return verify_cached(my_NFA, *cached) ? 0 : EXIT_FAILURE;
+            auto found = chrono::steady_clock::now();
+            if (!match_input.empty()) match_file(*cached, match_input);
+            else if (!batch_bench_input.empty()) bench_batch(*cached, batch_bench_input);
+            else if (!codegen_bench_input.empty()) bench_codegen(*cached, codegen_bench_input);
+            else {
+                cached->print_to_file("converted_dfa");
+                if (binary_output) cached->save("converted_dfa.dfab", string(cached->dictionary()));
+                if (!header_name.empty()) cached->print_header("converted_dfa", header_name, header_style);
+                //the lookup stands in for construction
+                chrono::duration<double> lookup = found - lookup_begin;
+                chrono::duration<double> write = chrono::steady_clock::now() - found;
+                if (!stats_format.empty()) {
+                    print_stats(my_NFA, cached->state_count() - 1, true, lookup.count(), 0, 
+                                write.count(), stats_format);
+                }
+            }
+            return 0;
+        }
+    }
+
+    auto phase_begin = chrono::steady_clock::now();
+    DFA my_DFA = DFA(my_NFA, order, threads, limits); //create dfa from nfa
+    auto constructed = chrono::steady_clock::now();
+
+    //edit the nfa and bring the dfa along, instead of converting again
+    if (!delta_file.empty() && my_DFA.complete()) {
+        StateSet touched = my_NFA.apply(delta_file);
+        UpdateResult update = my_DFA.update(my_NFA, touched, renumber);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - constructed;
+        cerr << "updated: " << update.reused << " states reused, " << update.explored 
+             << " explored, " << update.collected << " collected in " << elapsed.count() 
+             << " seconds" << endl;
+        if (cache) cache_key = ConversionCache::key(my_NFA, order, minimize);
+        constructed = chrono::steady_clock::now();
+    }
+
+    //past a limit there is no dfa. matching can still run on the nfa itself
+    if (!my_DFA.complete()) {
+        print_result(my_DFA.result());
+        if (match_input.empty()) exit(EXIT_FAILURE);
+        NFASimulator simulator(my_NFA);
+        cerr << "matching by nfa simulation (" << NFASimulator::kernel_name(simulator.kernel()) << ")" << endl;
+        match_file(simulator, match_input);
+        return 0;
+    }
+    if (minimize) {
+        int states_before = my_DFA.state_count();
+        my_DFA.minimize();
+        cerr << "minimized: " << states_before << " states -> " 
+             << my_DFA.state_count() << " states" << endl;
+    }
+    auto minimized = chrono::steady_clock::now();
+    if (verify) return verify_dfa(my_NFA, my_DFA) ? 0 : EXIT_FAILURE;
+    if (cache) cache->store(cache_key, my_DFA);
+    if (!match_input.empty()) {
+        match_file(CompiledDFA(my_DFA), match_input);
+        return 0;
+    }
+    if (!batch_bench_input.empty()) {
+        bench_batch(CompiledDFA(my_DFA), batch_bench_input);
+        return 0;
+    }
+    if (!codegen_bench_input.empty()) {
+        bench_codegen(CompiledDFA(my_DFA), codegen_bench_input);
+        return 0;
+    }
+
+    //there wasn't a specification for naming the file the dfa prints to,
+    //so using the name converted dfa. 
+    my_DFA.print_to_file("converted_dfa"); //create a file
+    if (binary_output) my_DFA.print_binary("converted_dfa");
+    if (!header_name.empty()) my_DFA.print_header("converted_dfa", header_name, header_style);
+    auto written = chrono::steady_clock::now();
+
+    if (!stats_format.empty()) {
+        auto seconds = [](chrono::steady_clock::time_point from, chrono::steady_clock::time_point to) {
+            return chrono::duration<double>(to - from).count();
+        };
+        print_stats(my_NFA, my_DFA.state_count(), false, seconds(phase_begin, constructed), 
+                    seconds(constructed, minimized), seconds(minimized, written), stats_format);
+    }
+
+    return 0;
+}
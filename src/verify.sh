@@ -0,0 +1,2 @@
+g++ -O2 -pthread nfa_dfa_converter.cpp -o verify
+./verify --verify-suite 2000